@@ -0,0 +1,420 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bigint.h"
+
+#define KARATSUBA_THRESHOLD 40  // shorter operand, in limbs
+#define FFT_THRESHOLD 800       // shorter operand, in limbs
+#define FFT_PIECE 1000          // limbs are split into 3 base-1000 pieces
+#define FFT_PIECES_PER_LIMB 3
+#define FFT_MAX_ROUNDING 0.25   // larger rounding errors fall back to Karatsuba
+#define WRITE_BUFFER 65536
+
+void bigInit(BigInt *x)
+{
+  x->limbs = NULL;
+  x->length = x->capacity = 0;
+}
+
+void bigFree(BigInt *x)
+{
+  free(x->limbs);
+  bigInit(x);
+}
+
+static int bigReserve(BigInt *x, size_t capacity)
+{
+  if (capacity <= x->capacity)
+    return 0;
+  uint32_t *limbs = realloc(x->limbs, sizeof(uint32_t) * capacity);
+  if (limbs == NULL)
+    return -1;
+  x->limbs = limbs;
+  x->capacity = capacity;
+  return 0;
+}
+
+static void trim(BigInt *x)
+{
+  while (x->length > 0 && x->limbs[x->length - 1] == 0)
+    x->length--;
+}
+
+int bigSetSmall(BigInt *x, uint64_t value)
+{
+  if (bigReserve(x, 3) != 0)
+    return -1;
+  x->length = 0;
+  while (value > 0)
+  {
+    x->limbs[x->length++] = (uint32_t)(value % BIGINT_BASE);
+    value /= BIGINT_BASE;
+  }
+  return 0;
+}
+
+int bigCopy(BigInt *dst, const BigInt *src)
+{
+  if (dst == src)
+    return 0;
+  if (bigReserve(dst, src->length) != 0)
+    return -1;
+  if (src->length)
+    memcpy(dst->limbs, src->limbs, sizeof(uint32_t) * src->length);
+  dst->length = src->length;
+  return 0;
+}
+
+int bigMulSmall(BigInt *x, uint32_t factor)
+{
+  if (factor == 0 || x->length == 0)
+  {
+    x->length = 0;
+    return 0;
+  }
+  if (bigReserve(x, x->length + 1) != 0)
+    return -1;
+  uint64_t carry = 0;
+  for (size_t i = 0; i < x->length; i++)
+  {
+    uint64_t t = (uint64_t)x->limbs[i] * factor + carry;
+    x->limbs[i] = (uint32_t)(t % BIGINT_BASE);
+    carry = t / BIGINT_BASE;
+  }
+  if (carry)
+    x->limbs[x->length++] = (uint32_t)carry;
+  return 0;
+}
+
+// --- Multiplication on raw limb arrays. out has na + nb limbs. ---
+
+static int mulRaw(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out);
+
+static void schoolbook(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+{
+  memset(out, 0, sizeof(uint32_t) * (na + nb));
+  for (size_t i = 0; i < na; i++)
+  {
+    uint64_t carry = 0, ai = a[i];
+    if (ai == 0)
+      continue;
+    for (size_t j = 0; j < nb; j++)
+    {
+      uint64_t t = out[i + j] + ai * b[j] + carry;
+      out[i + j] = (uint32_t)(t % BIGINT_BASE);
+      carry = t / BIGINT_BASE;
+    }
+    out[i + nb] = (uint32_t)carry;
+  }
+}
+
+// out[0..n) += x[0..nx); the sum must fit in n limbs.
+static void addInto(uint32_t *out, size_t n, const uint32_t *x, size_t nx)
+{
+  uint32_t carry = 0;
+  size_t i = 0;
+  for (; i < nx; i++)
+  {
+    uint32_t t = out[i] + x[i] + carry;
+    carry = t >= BIGINT_BASE;
+    out[i] = carry ? t - BIGINT_BASE : t;
+  }
+  for (; carry && i < n; i++)
+  {
+    uint32_t t = out[i] + 1;
+    carry = t == BIGINT_BASE;
+    out[i] = carry ? 0 : t;
+  }
+}
+
+// out[0..n) -= x[0..nx); out must not go negative.
+static void subInto(uint32_t *out, size_t n, const uint32_t *x, size_t nx)
+{
+  uint32_t borrow = 0;
+  size_t i = 0;
+  for (; i < nx; i++)
+  {
+    uint32_t sub = x[i] + borrow;
+    borrow = out[i] < sub;
+    out[i] = borrow ? out[i] + BIGINT_BASE - sub : out[i] - sub;
+  }
+  for (; borrow && i < n; i++)
+  {
+    borrow = out[i] == 0;
+    out[i] = borrow ? BIGINT_BASE - 1 : out[i] - 1;
+  }
+}
+
+// Karatsuba for na >= nb > na / 2: three half-size products instead of four.
+static int karatsuba(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+{
+  size_t m = na / 2;
+  size_t high = na - m;  // >= m, and >= nb - m
+  size_t sumLength = high + 1;
+  uint32_t *sa = calloc(4 * sumLength, sizeof(uint32_t));
+  if (sa == NULL)
+    return -1;
+  uint32_t *sb = sa + sumLength, *middle = sb + sumLength;
+
+  // out = a0*b0 + a1*b1 * BASE^(2m)
+  if (mulRaw(a, m, b, m, out) != 0 || mulRaw(a + m, na - m, b + m, nb - m, out + 2 * m) != 0)
+  {
+    free(sa);
+    return -1;
+  }
+
+  // middle = (a0 + a1)(b0 + b1) - a0*b0 - a1*b1
+  memcpy(sa, a + m, sizeof(uint32_t) * (na - m));
+  addInto(sa, sumLength, a, m);
+  memcpy(sb, b + m, sizeof(uint32_t) * (nb - m));
+  addInto(sb, sumLength, b, m);
+  if (mulRaw(sa, sumLength, sb, sumLength, middle) != 0)
+  {
+    free(sa);
+    return -1;
+  }
+  subInto(middle, 2 * sumLength, out, 2 * m);
+  subInto(middle, 2 * sumLength, out + 2 * m, na + nb - 2 * m);
+
+  size_t room = na + nb - m, used = 2 * sumLength;
+  while (used > room)  // the top limbs are zero after the subtractions
+    used--;
+  addInto(out + m, room, middle, used);
+  free(sa);
+  return 0;
+}
+
+// Roots of unity laid out by stage: for each power of two length L,
+// rootCos/rootSin[L / 2 + k] = cos/sin(2 PI k / L), k < L / 2. The layout
+// does not depend on the transform size, so one table serves every call and
+// each butterfly loop reads it sequentially. Grown on demand; not thread-safe.
+static double *rootCos, *rootSin;
+static size_t rootCount;
+
+static int reserveRoots(size_t n)
+{
+  if (n <= rootCount)
+    return 0;
+  double *c = realloc(rootCos, sizeof(double) * n);
+  if (c == NULL)
+    return -1;
+  rootCos = c;
+  double *s = realloc(rootSin, sizeof(double) * n);
+  if (s == NULL)
+    return -1;
+  rootSin = s;
+  for (size_t length = rootCount ? rootCount * 2 : 2; length <= n; length *= 2)
+  {
+    for (size_t k = 0; k < length / 2; k++)
+    {
+      double angle = 2.0 * M_PI * (double)k / (double)length;
+      rootCos[length / 2 + k] = cos(angle);
+      rootSin[length / 2 + k] = sin(angle);
+    }
+  }
+  rootCount = n;
+  return 0;
+}
+
+// In-place radix-2 FFT of n = 2^k points (re, im); inverse flips the sign
+// of the angle and does not scale.
+static void fft(double *re, double *im, size_t n, int inverse)
+{
+  for (size_t i = 1, j = 0; i < n; i++)
+  {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j |= bit;
+    if (i < j)
+    {
+      double t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+  double sign = inverse ? 1.0 : -1.0;
+  for (size_t length = 2; length <= n; length <<= 1)
+  {
+    size_t half = length / 2;
+    const double *wCos = rootCos + half, *wSin = rootSin + half;
+    for (size_t start = 0; start < n; start += length)
+    {
+      double *pr = re + start, *pi = im + start, *qr = pr + half, *qi = pi + half;
+      for (size_t k = 0; k < half; k++)
+      {
+        double wr = wCos[k], wi = sign * wSin[k];
+        double xr = qr[k] * wr - qi[k] * wi;
+        double xi = qr[k] * wi + qi[k] * wr;
+        qr[k] = pr[k] - xr;
+        qi[k] = pi[k] - xi;
+        pr[k] += xr;
+        pi[k] += xi;
+      }
+    }
+  }
+}
+
+// Multiplies by one complex FFT: a goes in the real part and b in the
+// imaginary part, and the product spectrum is (Z(k)^2 - conj(Z(n-k))^2) / 4i.
+// Returns -1 if memory runs out or the rounding error is too large to trust.
+static int fftMultiply(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+{
+  size_t pieces = FFT_PIECES_PER_LIMB * (na + nb);
+  size_t n = 1;
+  while (n < pieces)
+    n <<= 1;
+  double *re = calloc(n, sizeof(double));
+  double *im = calloc(n, sizeof(double));
+  int result = -1;
+  if (re && im && reserveRoots(n) == 0)
+  {
+    for (size_t i = 0; i < na; i++)
+    {
+      re[3 * i] = a[i] % FFT_PIECE;
+      re[3 * i + 1] = a[i] / FFT_PIECE % FFT_PIECE;
+      re[3 * i + 2] = a[i] / (FFT_PIECE * FFT_PIECE);
+    }
+    for (size_t i = 0; i < nb; i++)
+    {
+      im[3 * i] = b[i] % FFT_PIECE;
+      im[3 * i + 1] = b[i] / FFT_PIECE % FFT_PIECE;
+      im[3 * i + 2] = b[i] / (FFT_PIECE * FFT_PIECE);
+    }
+    fft(re, im, n, 0);
+
+    for (size_t k = 0; k <= n / 2; k++)
+    {
+      size_t j = (n - k) & (n - 1);
+      double zr = re[k], zi = im[k], cr = re[j], ci = -im[j];  // Z(k), conj(Z(n-k))
+      // (Z(k)^2 - conj(Z(n-k))^2) / 4i, and the same with k and n-k swapped
+      double pr = zr * zr - zi * zi - (cr * cr - ci * ci), pi = 2 * zr * zi - 2 * cr * ci;
+      double qr = cr * cr - ci * ci - (zr * zr - zi * zi), qi = 2 * cr * -ci - 2 * zr * -zi;
+      re[k] = pi / 4;
+      im[k] = -pr / 4;
+      re[j] = qi / 4;
+      im[j] = -qr / 4;
+    }
+    fft(re, im, n, 1);
+
+    double worst = 0.0;
+    uint64_t carry = 0;
+    memset(out, 0, sizeof(uint32_t) * (na + nb));
+    static const uint32_t scale[FFT_PIECES_PER_LIMB] = { 1, FFT_PIECE, FFT_PIECE * FFT_PIECE };
+    for (size_t i = 0; i < pieces; i++)
+    {
+      double value = re[i] / (double)n;
+      double rounded = floor(value + 0.5);
+      if (rounded < 0.0)
+      {
+        worst = 1.0;
+        break;
+      }
+      if (fabs(value - rounded) > worst)
+        worst = fabs(value - rounded);
+      carry += (uint64_t)rounded;
+      out[i / 3] += (uint32_t)(carry % FFT_PIECE) * scale[i % 3];
+      carry /= FFT_PIECE;
+    }
+    result = worst <= FFT_MAX_ROUNDING && carry == 0 ? 0 : -1;
+  }
+  free(re);
+  free(im);
+  return result;
+}
+
+static int mulRaw(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+{
+  if (na < nb)
+  {
+    const uint32_t *t = a;
+    a = b;
+    b = t;
+    size_t tn = na;
+    na = nb;
+    nb = tn;
+  }
+  if (nb < KARATSUBA_THRESHOLD)
+  {
+    schoolbook(a, na, b, nb, out);
+    return 0;
+  }
+  if (nb >= FFT_THRESHOLD && fftMultiply(a, na, b, nb, out) == 0)
+    return 0;
+  if (na >= 2 * nb)
+  {
+    // Unbalanced: multiply b by nb-limb slices of a and add them up.
+    uint32_t *slice = malloc(sizeof(uint32_t) * 2 * nb);
+    if (slice == NULL)
+      return -1;
+    memset(out, 0, sizeof(uint32_t) * (na + nb));
+    for (size_t offset = 0; offset < na; offset += nb)
+    {
+      size_t length = na - offset < nb ? na - offset : nb;
+      if (mulRaw(a + offset, length, b, nb, slice) != 0)
+      {
+        free(slice);
+        return -1;
+      }
+      addInto(out + offset, na + nb - offset, slice, length + nb);
+    }
+    free(slice);
+    return 0;
+  }
+  return karatsuba(a, na, b, nb, out);
+}
+
+int bigMul(BigInt *out, const BigInt *a, const BigInt *b)
+{
+  if (a->length == 0 || b->length == 0)
+  {
+    out->length = 0;
+    return 0;
+  }
+  size_t length = a->length + b->length;
+  uint32_t *limbs = malloc(sizeof(uint32_t) * length);
+  if (limbs == NULL || mulRaw(a->limbs, a->length, b->limbs, b->length, limbs) != 0)
+  {
+    free(limbs);
+    return -1;
+  }
+  free(out->limbs);
+  out->limbs = limbs;
+  out->length = out->capacity = length;
+  trim(out);
+  return 0;
+}
+
+size_t bigDecimalDigits(const BigInt *x)
+{
+  if (x->length == 0)
+    return 1;
+  size_t digits = (x->length - 1) * BIGINT_BASE_DIGITS;
+  for (uint32_t top = x->limbs[x->length - 1]; top > 0; top /= 10)
+    digits++;
+  return digits;
+}
+
+int bigWrite(FILE *out, const BigInt *x)
+{
+  if (x->length == 0)
+    return fputc('0', out) == EOF ? -1 : 0;
+  char buffer[WRITE_BUFFER];
+  size_t used = (size_t)snprintf(buffer, sizeof(buffer), "%u", x->limbs[x->length - 1]);
+  for (size_t i = x->length - 1; i-- > 0;)
+  {
+    if (used + BIGINT_BASE_DIGITS > sizeof(buffer))
+    {
+      if (fwrite(buffer, 1, used, out) != used)
+        return -1;
+      used = 0;
+    }
+    uint32_t limb = x->limbs[i];
+    for (int d = BIGINT_BASE_DIGITS - 1; d >= 0; d--)
+    {
+      buffer[used + d] = (char)('0' + limb % 10);
+      limb /= 10;
+    }
+    used += BIGINT_BASE_DIGITS;
+  }
+  return fwrite(buffer, 1, used, out) == used ? 0 : -1;
+}
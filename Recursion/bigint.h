@@ -0,0 +1,39 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BIGINT_BASE 1000000000u  // each limb holds 9 decimal digits
+#define BIGINT_BASE_DIGITS 9
+
+// Non-negative integer in base 10^9, least significant limb first.
+// length 0 means zero; the top limb is never 0 otherwise.
+typedef struct
+{
+  uint32_t *limbs;
+  size_t length, capacity;
+} BigInt;
+
+void bigInit(BigInt *x);
+void bigFree(BigInt *x);
+
+// All functions below return 0, or -1 if memory runs out.
+int bigSetSmall(BigInt *x, uint64_t value);
+int bigCopy(BigInt *dst, const BigInt *src);
+
+// x *= factor, for factor < BIGINT_BASE.
+int bigMulSmall(BigInt *x, uint32_t factor);
+
+// out = a * b; out may be a or b. Picks schoolbook, Karatsuba or a double
+// precision FFT by operand size.
+int bigMul(BigInt *out, const BigInt *a, const BigInt *b);
+
+// Number of decimal digits (1 for zero).
+size_t bigDecimalDigits(const BigInt *x);
+
+// Writes x in decimal, streaming through a small buffer. Returns 0 or -1.
+int bigWrite(FILE *out, const BigInt *x);
+
+#endif
@@ -0,0 +1,20 @@
+#!/bin/bash
+# Usage: ./build.sh            build every program below
+#        ./build.sh <program>  build one: factorial, factorial-mod, color-map, dsatur or recolor
+# The coloring programs (color-map, dsatur, recolor) run their searches on the
+# work-stealing pool in ../Space World/parallel.c, which they compile in; the
+# rest need nothing outside this directory.
+CFLAGS="-O2"
+PARALLEL="../Space World/parallel.c"
+PROGRAMS="${1:-factorial factorial-mod color-map dsatur recolor}"
+
+for program in $PROGRAMS; do
+  case $program in
+    factorial)     clang $CFLAGS factorial.c bigint.c -lm -o factorial ;;
+    factorial-mod) clang $CFLAGS factorial-mod.c -o factorial-mod ;;
+    color-map)     clang $CFLAGS color-map.c graph.c dsatur.c "$PARALLEL" -DDSATUR_NO_MAIN -pthread -o color-map ;;
+    dsatur)        clang $CFLAGS dsatur.c graph.c "$PARALLEL" -pthread -o dsatur ;;
+    recolor)       clang $CFLAGS recolor.c dsatur.c graph.c "$PARALLEL" -DDSATUR_NO_MAIN -pthread -o recolor ;;
+    *)             echo "Unknown program: $program" >&2; exit 1 ;;
+  esac || exit 1
+done
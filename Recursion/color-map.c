@@ -1,19 +1,20 @@
+// Build with: clang -O2 color-map.c graph.c dsatur.c "../Space World/parallel.c" -DDSATUR_NO_MAIN -pthread -o color-map
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
-
-#define NUM_REGIONS 13
-#define MAX_COLORS 4
+#include "color-map.h"
+#include "dsatur.h"
 
 int colors[NUM_REGIONS] = {0};
-int *map[NUM_REGIONS];
-int map_sizes[NUM_REGIONS];
+Graph map;
 
 bool isSafe(int region, int colorToTry)
 {
-  for (int i = 0; i < map_sizes[region]; i++)
+  const int *neighbor = map.neighbors + map.offsets[region];
+  const int *end = map.neighbors + map.offsets[region + 1];
+  for (; neighbor < end; neighbor++)
   {
-    int neighbor = map[region][i];
-    if (colors[neighbor] == colorToTry)
+    if (colors[*neighbor] == colorToTry)
       return false;
   }
   return true;
@@ -39,6 +40,11 @@ bool colorMap(int region)
   return false;
 }
 
+bool colorMapParallel(int threads)
+{
+  return dsaturColorParallel(&map, MAX_COLORS, threads, colors, NULL) == 1;
+}
+
 void printColors()
 {
   printf("\nColoring Results\n");
@@ -78,50 +84,42 @@ void printRegionColored(int color) {
   printf("\033[%dm[%d]\033[0m", ansi_color, color);
 }
 
-int main(void)
+// Builds the demo map's adjacency. Each border is listed once; the graph
+// stores it in both directions.
+void initMap(void)
 {
-  static int neighbors_0[] = {1, 2, 3, 9, 12};
-  static int neighbors_1[] = {0, 2, 5};
-  static int neighbors_2[] = {0, 1, 3, 4, 5};
-  static int neighbors_3[] = {0, 2, 4, 6, 8, 9};
-  static int neighbors_4[] = {2, 3, 5, 6, 7, 8};
-  static int neighbors_5[] = {1, 2, 8, 11};
-  static int neighbors_6[] = {3, 4, 7, 8};
-  static int neighbors_7[] = {4, 6, 8};
-  static int neighbors_8[] = {3, 5, 6, 7, 9, 10, 11};
-  static int neighbors_9[] = {0, 3, 8, 10, 12};
-  static int neighbors_10[] = {8, 9, 11, 12};
-  static int neighbors_11[] = {5, 8, 10, 12};
-  static int neighbors_12[] = {0, 9, 10, 11};
-
-  map[0] = neighbors_0;
-  map_sizes[0] = 5;
-  map[1] = neighbors_1;
-  map_sizes[1] = 3;
-  map[2] = neighbors_2;
-  map_sizes[2] = 5;
-  map[3] = neighbors_3;
-  map_sizes[3] = 6;
-  map[4] = neighbors_4;
-  map_sizes[4] = 6;
-  map[5] = neighbors_5;
-  map_sizes[5] = 4;
-  map[6] = neighbors_6;
-  map_sizes[6] = 4;
-  map[7] = neighbors_7;
-  map_sizes[7] = 3;
-  map[8] = neighbors_8;
-  map_sizes[8] = 7;
-  map[9] = neighbors_9;
-  map_sizes[9] = 5;
-  map[10] = neighbors_10;
-  map_sizes[10] = 4;
-  map[11] = neighbors_11;
-  map_sizes[11] = 4;
-  map[12] = neighbors_12;
-  map_sizes[12] = 4;
-
-  if (colorMap(0))
+  static const int borders[][2] = {
+    {0, 1}, {0, 2}, {0, 3}, {0, 9}, {0, 12},
+    {1, 2}, {1, 5},
+    {2, 3}, {2, 4}, {2, 5},
+    {3, 4}, {3, 6}, {3, 8}, {3, 9},
+    {4, 5}, {4, 6}, {4, 7}, {4, 8},
+    {5, 8}, {5, 11},
+    {6, 7}, {6, 8},
+    {7, 8},
+    {8, 9}, {8, 10}, {8, 11},
+    {9, 10}, {9, 12},
+    {10, 11}, {10, 12},
+    {11, 12}
+  };
+
+  GraphBuilder builder;
+  graphBuilderInit(&builder, NUM_REGIONS);
+  for (size_t i = 0; i < sizeof(borders) / sizeof(borders[0]); i++)
+    graphBuilderAddEdge(&builder, borders[i][0], borders[i][1]);
+  freeGraph(&map);
+  graphBuilderFinish(&builder, &map);
+}
+
+#ifndef COLOR_MAP_NO_MAIN
+// Usage: color-map [threads]  (a thread count selects the parallel solver)
+int main(int argc, char *argv[])
+{
+  initMap();
+
+  bool solved = argc > 1 ? colorMapParallel(atoi(argv[1])) : colorMap(0);
+  freeGraph(&map);
+  if (solved)
   {
     printColors();
     printAsciiMap();
@@ -131,3 +129,4 @@ int main(void)
 
   return 0;
 }
+#endif
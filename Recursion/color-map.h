@@ -0,0 +1,27 @@
+#ifndef COLOR_MAP_H
+#define COLOR_MAP_H
+
+#include <stdbool.h>
+#include "graph.h"
+
+#define NUM_REGIONS 13
+#define MAX_COLORS 4
+
+// Color of each region (0 = uncolored).
+extern int colors[NUM_REGIONS];
+
+// Region adjacency in CSR form, built by initMap.
+extern Graph map;
+
+// Builds the demo map's adjacency graph.
+void initMap(void);
+
+// Colors regions region..NUM_REGIONS-1 by backtracking.
+bool colorMap(int region);
+
+// Colors every region with the parallel DSATUR solver on up to threads
+// threads (<= 0: every CPU). Fills colors[]; false if no coloring exists.
+// Link with dsatur.c (-DDSATUR_NO_MAIN), graph.c and ../Space World/parallel.c.
+bool colorMapParallel(int threads);
+
+#endif
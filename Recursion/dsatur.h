@@ -0,0 +1,42 @@
+#ifndef DSATUR_H
+#define DSATUR_H
+
+#include <stdint.h>
+#include "graph.h"
+
+// Domains are 64-bit masks, so at most this many colors.
+#define DSATUR_MAX_COLORS 64
+
+typedef struct
+{
+  long nodes;       // color assignments tried
+  long backtracks;  // assignments undone
+} ColoringStats;
+
+// Colors graph with colors 1..maxColors by exact backtracking search.
+// Picks the uncolored vertex with the fewest remaining colors next (DSATUR,
+// ties to the higher degree), removes each assigned color from the neighbors'
+// domains (forward checking), and only opens one new color per level, so
+// color permutations are never re-explored. The search uses an explicit
+// stack, so depth is bounded by memory rather than the call stack.
+//
+// Returns 1 and fills colors[] on success, 0 if no coloring exists, and -1 on
+// bad input or once nodeLimit assignments were tried (0 = no limit).
+// stats may be NULL.
+int dsaturColor(const Graph *graph, int maxColors, long nodeLimit, int *colors, ColoringStats *stats);
+
+// Same search where vertex v may only take the colors set in domains[v]
+// (bit c = color c + 1), e.g. to recolor part of a graph around fixed
+// neighbors. Returns 0 at once if some domain is empty.
+int dsaturColorRestricted(const Graph *graph, int maxColors, const uint64_t *domains, long nodeLimit,
+                          int *colors, ColoringStats *stats);
+
+// Same search on up to threads threads (<= 0: every CPU). The top levels of
+// the search tree are split into independent subproblems, each solved on a
+// thread-local copy of the state by the work-stealing pool in
+// Space World/parallel.c. The first solution found cancels the rest. Which
+// valid coloring is returned may vary between runs. Returns 1, 0 or -1 (bad
+// input or out of memory) like dsaturColor.
+int dsaturColorParallel(const Graph *graph, int maxColors, int threads, int *colors, ColoringStats *stats);
+
+#endif
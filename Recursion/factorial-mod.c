@@ -0,0 +1,297 @@
+// n! mod p and binomial coefficients mod p for huge n.
+// Build with: clang -O2 factorial-mod.c -o factorial-mod
+#include <stdio.h>
+#include <stdlib.h>
+#include "factorial-mod.h"
+
+static uint32_t mulMod(uint32_t a, uint32_t b, uint32_t p)
+{
+  return (uint32_t)((uint64_t)a * b % p);
+}
+
+static uint32_t powMod(uint32_t base, uint64_t exponent, uint32_t p)
+{
+  uint32_t result = 1 % p;
+  while (exponent > 0)
+  {
+    if (exponent & 1)
+      result = mulMod(result, base, p);
+    base = mulMod(base, base, p);
+    exponent >>= 1;
+  }
+  return result;
+}
+
+// Deterministic Miller-Rabin for 32-bit n (bases 2, 7 and 61 suffice).
+static int isPrime(uint32_t n)
+{
+  if (n < 2)
+    return 0;
+  static const uint32_t bases[] = { 2, 7, 61 };
+  for (int i = 0; i < 3; i++)
+  {
+    if (n == bases[i])
+      return 1;
+    if (n % bases[i] == 0)
+      return 0;
+  }
+  uint32_t d = n - 1;
+  int shifts = 0;
+  while ((d & 1) == 0)
+  {
+    d >>= 1;
+    shifts++;
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    uint32_t x = powMod(bases[i], d, n);
+    if (x == 1 || x == n - 1)
+      continue;
+    int composite = 1;
+    for (int s = 1; s < shifts && composite; s++)
+    {
+      x = mulMod(x, x, n);
+      composite = x != n - 1;
+    }
+    if (composite)
+      return 0;
+  }
+  return 1;
+}
+
+int factorialModInit(FactorialModTable *table, uint32_t p, uint32_t limit)
+{
+  table->fact = table->invFact = table->checkpoints = NULL;
+  if (!isPrime(p))
+    return -1;
+  if (limit == 0)
+    limit = FACTORIAL_MOD_DEFAULT_LIMIT;
+  if (limit > p - 1)
+    limit = p - 1;
+  table->p = p;
+  table->limit = limit;
+  table->fact = malloc(sizeof(uint32_t) * ((size_t)limit + 1));
+  table->invFact = malloc(sizeof(uint32_t) * ((size_t)limit + 1));
+  if (table->fact == NULL || table->invFact == NULL)
+  {
+    factorialModFree(table);
+    return -1;
+  }
+
+  table->fact[0] = 1 % p;
+  for (uint32_t m = 1; m <= limit; m++)
+    table->fact[m] = mulMod(table->fact[m - 1], m, p);
+  // One inversion by Fermat, then (m-1)!^-1 = m!^-1 * m on the way down.
+  table->invFact[limit] = powMod(table->fact[limit], p - 2, p);
+  for (uint32_t m = limit; m > 0; m--)
+    table->invFact[m - 1] = mulMod(table->invFact[m], m, p);
+
+  // Residues past (p - 1) / 2 reduce to ones below it, so checkpoints up
+  // to there cover whatever the table does not.
+  uint32_t half = (p - 1) / 2;
+  if (half > limit)
+  {
+    table->checkpoints = malloc(sizeof(uint32_t) * ((size_t)half / FACTORIAL_MOD_STRIDE + 1));
+    if (table->checkpoints == NULL)
+    {
+      factorialModFree(table);
+      return -1;
+    }
+    // Products of four strides at a time are independent, which hides the
+    // latency of the division; chaining them gives the checkpoints.
+    uint32_t blocks = half / FACTORIAL_MOD_STRIDE;
+    table->checkpoints[0] = 1 % p;
+    for (uint32_t j = 0; j < blocks; j += 4)
+    {
+      uint32_t lanes = blocks - j < 4 ? blocks - j : 4;
+      uint32_t product[4] = { 1, 1, 1, 1 };
+      for (uint32_t i = 1; i <= FACTORIAL_MOD_STRIDE; i++)
+      {
+        for (uint32_t lane = 0; lane < 4; lane++)
+          product[lane] = mulMod(product[lane], (j + lane) * FACTORIAL_MOD_STRIDE + i, p);
+      }
+      for (uint32_t lane = 0; lane < lanes; lane++)
+        table->checkpoints[j + lane + 1] = mulMod(table->checkpoints[j + lane], product[lane], p);
+    }
+  }
+  return 0;
+}
+
+void factorialModFree(FactorialModTable *table)
+{
+  free(table->fact);
+  free(table->invFact);
+  free(table->checkpoints);
+  table->fact = table->invFact = table->checkpoints = NULL;
+}
+
+// m! mod p for m <= (p - 1) / 2: from the table or the checkpoint below m.
+static uint32_t lowerFactorial(const FactorialModTable *table, uint32_t m)
+{
+  if (m <= table->limit)
+    return table->fact[m];
+  uint32_t base = m / FACTORIAL_MOD_STRIDE * FACTORIAL_MOD_STRIDE;
+  uint32_t result = table->checkpoints[m / FACTORIAL_MOD_STRIDE];
+  for (uint32_t j = base + 1; j <= m; j++)
+    result = mulMod(result, j, table->p);
+  return result;
+}
+
+// m! mod p for m < p. Wilson's theorem, (p-1)! = -1, gives
+// m! * (p-1-m)! = (-1)^(m+1) for odd p.
+static uint32_t residueFactorial(const FactorialModTable *table, uint32_t m)
+{
+  uint32_t p = table->p;
+  if (m <= table->limit)
+    return table->fact[m];
+  if (p - 1 - m <= table->limit)
+  {
+    uint32_t inverse = table->invFact[p - 1 - m];
+    return (m & 1) ? inverse : (p - inverse) % p;
+  }
+  if (m <= (p - 1) / 2)
+    return lowerFactorial(table, m);
+  uint32_t inverse = powMod(lowerFactorial(table, p - 1 - m), p - 2, p);
+  return (m & 1) ? inverse : (p - inverse) % p;
+}
+
+// (m!)^-1 mod p for m < p.
+static uint32_t residueInverseFactorial(const FactorialModTable *table, uint32_t m)
+{
+  uint32_t p = table->p;
+  if (m <= table->limit)
+    return table->invFact[m];
+  if (p - 1 - m <= table->limit)
+  {
+    uint32_t value = table->fact[p - 1 - m];
+    return (m & 1) ? value : (p - value) % p;
+  }
+  if (m <= (p - 1) / 2)
+    return powMod(lowerFactorial(table, m), p - 2, p);
+  uint32_t value = lowerFactorial(table, p - 1 - m);
+  return (m & 1) ? value : (p - value) % p;
+}
+
+uint32_t factorialMod(const FactorialModTable *table, uint64_t n)
+{
+  if (n >= table->p)
+    return 0;
+  return residueFactorial(table, (uint32_t)n);
+}
+
+// n! = p^e * r: peel off the base-p digits, using
+// n! / p^(n/p) (n/p)! = (-1)^(n/p) * (n mod p)!  (mod p).
+uint32_t factorialModStripped(const FactorialModTable *table, uint64_t n, uint64_t *exponent)
+{
+  uint32_t p = table->p, result = 1 % p;
+  uint64_t e = 0;
+  while (n > 0)
+  {
+    result = mulMod(result, residueFactorial(table, (uint32_t)(n % p)), p);
+    n /= p;
+    if ((n & 1) && p != 2)
+      result = (p - result) % p;
+    e += n;
+  }
+  if (exponent)
+    *exponent = e;
+  return result;
+}
+
+uint32_t binomialMod(const FactorialModTable *table, uint64_t n, uint64_t k)
+{
+  uint32_t p = table->p, result = 1 % p;
+  if (k > n)
+    return 0;
+  while (k > 0 && result != 0)
+  {
+    uint32_t ni = (uint32_t)(n % p), ki = (uint32_t)(k % p);
+    if (ki > ni)
+      return 0;
+    result = mulMod(result, residueFactorial(table, ni), p);
+    result = mulMod(result, residueInverseFactorial(table, ki), p);
+    result = mulMod(result, residueInverseFactorial(table, ni - ki), p);
+    n /= p;
+    k /= p;
+  }
+  return result;
+}
+
+void binomialModBatch(const FactorialModTable *table, const uint64_t *n, const uint64_t *k,
+                      uint32_t *out, size_t count)
+{
+  uint32_t p = table->p, limit = table->limit;
+  for (size_t i = 0; i < count; i++)
+  {
+    // Most queries are a single table lookup per factor.
+    if (n[i] <= limit && k[i] <= n[i])
+    {
+      uint64_t value = (uint64_t)table->fact[n[i]] * table->invFact[k[i]] % p;
+      out[i] = (uint32_t)(value * table->invFact[n[i] - k[i]] % p);
+    }
+    else
+      out[i] = binomialMod(table, n[i], k[i]);
+  }
+}
+
+#ifndef FACTORIAL_MOD_NO_MAIN
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+
+// Parses a whole decimal argument no greater than max. Returns 0, or -1 if
+// text is not a number, is negative or is out of range.
+static int parseArgument(const char *text, unsigned long long max, unsigned long long *value)
+{
+  char *end;
+  while (isspace((unsigned char)*text))
+    text++;
+  if (!isdigit((unsigned char)*text))
+    return -1;
+  errno = 0;
+  *value = strtoull(text, &end, 10);
+  if (errno != 0 || *end != '\0' || *value > max)
+    return -1;
+  return 0;
+}
+
+// Usage: factorial-mod <prime> <n> [k]
+int main(int argc, char *argv[])
+{
+  if (argc < 3)
+  {
+    printf("Usage: %s <prime> <n> [k]\n", argv[0]);
+    printf("Prints n! mod prime, or C(n, k) mod prime when k is given.\n");
+    return 1;
+  }
+
+  FactorialModTable table;
+  unsigned long long prime, n, k = 0;
+  if (parseArgument(argv[1], UINT32_MAX, &prime) != 0 || factorialModInit(&table, (uint32_t)prime, 0) != 0)
+  {
+    printf("Error: %s is not a prime below 2^32.\n", argv[1]);
+    return 1;
+  }
+  uint32_t p = (uint32_t)prime;
+  if (parseArgument(argv[2], ULLONG_MAX, &n) != 0 || (argc > 3 && parseArgument(argv[3], ULLONG_MAX, &k) != 0))
+  {
+    printf("Error: n and k must be whole numbers below 2^64.\n");
+    factorialModFree(&table);
+    return 1;
+  }
+  if (argc > 3)
+  {
+    printf("C(%llu, %llu) mod %u = %u\n", n, k, p, binomialMod(&table, n, k));
+  }
+  else
+  {
+    uint64_t exponent;
+    uint32_t stripped = factorialModStripped(&table, n, &exponent);
+    // p divides n! exactly when some p was stripped.
+    printf("%llu! mod %u = %u\n", n, p, exponent ? 0 : stripped);
+    printf("%llu! = %u^%llu * r, r mod %u = %u\n", n, p, (unsigned long long)exponent, p, stripped);
+  }
+  factorialModFree(&table);
+  return 0;
+}
+#endif
@@ -1,31 +1,100 @@
+// Build with: clang -O2 factorial.c bigint.c -lm -o factorial
 #include <stdio.h>
-#include <errno.h>
-#include <string.h>
+#include <stdlib.h>
+#include "factorial.h"
 
-unsigned long factorial(int n) {
-    if (n < 0) {
-        errno = EDOM;  // Domain error (standard error code for math functions)
-        return 0;
+#define PRODUCT_LEAF 64  // ranges this short are multiplied one factor at a time
+
+// result = (low + 1) * (low + 2) * ... * high, for low < high.
+static int productRange(unsigned long low, unsigned long high, BigInt *result) {
+    if (high - low <= PRODUCT_LEAF) {
+        // Pack consecutive factors into one limb-sized multiplier.
+        uint64_t packed = 1;
+        if (bigSetSmall(result, 1) != 0)
+            return -1;
+        for (unsigned long k = low + 1; k <= high; k++) {
+            if (packed * k >= BIGINT_BASE) {
+                if (bigMulSmall(result, (uint32_t)packed) != 0)
+                    return -1;
+                packed = 1;
+            }
+            packed *= k;
+        }
+        return bigMulSmall(result, (uint32_t)packed);
     }
 
-    if (n == 0) return 1;
-    return (unsigned long)n * factorial(n - 1);
+    unsigned long middle = low + (high - low) / 2;
+    BigInt left, right;
+    bigInit(&left);
+    bigInit(&right);
+    int status = -1;
+    if (productRange(low, middle, &left) == 0 && productRange(middle, high, &right) == 0)
+        status = bigMul(result, &left, &right);
+    bigFree(&left);
+    bigFree(&right);
+    return status;
 }
 
-int main() {
-    int n;
-    printf("Enter a non-negative number: ");
-    scanf("%d", &n);
+int bigFactorial(unsigned long n, BigInt *result) {
+    static BigInt memo[FACTORIAL_MEMO_LIMIT + 1];
+    static unsigned long memoCount = 0;  // memo[0..memoCount) are filled
 
-    errno = 0;  // Clear errno before calling the function
+    if (n >= BIGINT_BASE)
+        return -1;
+    if (n > FACTORIAL_MEMO_LIMIT)
+        return productRange(1, n, result);
 
-    unsigned long result = factorial(n);
+    while (memoCount <= n) {
+        BigInt *next = &memo[memoCount];
+        int status = memoCount == 0 ? bigSetSmall(next, 1)
+                                    : bigCopy(next, &memo[memoCount - 1]) || bigMulSmall(next, (uint32_t)memoCount);
+        if (status != 0)
+            return -1;
+        memoCount++;
+    }
+    return bigCopy(result, &memo[n]);
+}
 
-    if (errno == EDOM) {
-        printf("Error: factorial not defined for negative numbers.\n");
+#ifndef FACTORIAL_NO_MAIN
+#include <errno.h>
+
+// Usage: factorial [n]  (prompts for n when it is not given)
+int main(int argc, char *argv[]) {
+    long n;
+    if (argc > 1) {
+        char *end;
+        errno = 0;
+        n = strtol(argv[1], &end, 10);
+        if (end == argv[1] || *end != '\0') {
+            printf("Error: %s is not a whole number.\n", argv[1]);
+            return 1;
+        }
+        if (errno != 0) {
+            printf("Error: %s is out of range.\n", argv[1]);
+            return 1;
+        }
     } else {
-        printf("Factorial of %d is %lu\n", n, result);
+        printf("Enter a non-negative number: ");
+        if (scanf("%ld", &n) != 1)
+            return 1;
+    }
+
+    if (n < 0) {
+        printf("Error: factorial not defined for negative numbers.\n");
+        return 1;
+    }
+
+    BigInt result;
+    bigInit(&result);
+    if (bigFactorial((unsigned long)n, &result) != 0) {
+        printf("Error: %ld! is too large to compute.\n", n);
+        return 1;
     }
+    printf("Factorial of %ld (%zu digits) is ", n, bigDecimalDigits(&result));
+    bigWrite(stdout, &result);
+    printf("\n");
+    bigFree(&result);
 
     return 0;
 }
+#endif
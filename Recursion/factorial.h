@@ -0,0 +1,14 @@
+#ifndef FACTORIAL_H
+#define FACTORIAL_H
+
+#include "bigint.h"
+
+// Exact n! for n < 10^9 (for n! mod p see factorial-mod.h). Products of
+// ranges are split in halves (binary splitting) so the big multiplications
+// are balanced and reach the Karatsuba and FFT sizes; n <=
+// FACTORIAL_MEMO_LIMIT is memoized. Not thread-safe because of the memo
+// table. Returns 0, or -1 if memory runs out or n is too large.
+#define FACTORIAL_MEMO_LIMIT 1000
+int bigFactorial(unsigned long n, BigInt *result);
+
+#endif
@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "graph.h"
+
+#define MAX_GRAPH_LINE 256
+
+static int compareInts(const void *a, const void *b)
+{
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+int buildGraph(Graph *graph, int vertexCount, const int *from, const int *to, long edgeCount)
+{
+  memset(graph, 0, sizeof(*graph));
+  if (vertexCount < 0 || edgeCount < 0)
+    return -1;
+  for (long e = 0; e < edgeCount; e++)
+  {
+    if (from[e] < 0 || from[e] >= vertexCount || to[e] < 0 || to[e] >= vertexCount)
+      return -1;
+  }
+
+  long *offsets = calloc((size_t)vertexCount + 1, sizeof(long));
+  if (offsets == NULL)
+    return -1;
+  for (long e = 0; e < edgeCount; e++)
+  {
+    if (from[e] != to[e])
+    {
+      offsets[from[e] + 1]++;
+      offsets[to[e] + 1]++;
+    }
+  }
+  for (int v = 0; v < vertexCount; v++)
+    offsets[v + 1] += offsets[v];
+
+  int *neighbors = malloc(sizeof(int) * (offsets[vertexCount] ? offsets[vertexCount] : 1));
+  long *fill = malloc(sizeof(long) * ((size_t)vertexCount + 1));
+  if (neighbors == NULL || fill == NULL)
+  {
+    free(offsets);
+    free(neighbors);
+    free(fill);
+    return -1;
+  }
+  memcpy(fill, offsets, sizeof(long) * ((size_t)vertexCount + 1));
+  for (long e = 0; e < edgeCount; e++)
+  {
+    if (from[e] != to[e])
+    {
+      neighbors[fill[from[e]]++] = to[e];
+      neighbors[fill[to[e]]++] = from[e];
+    }
+  }
+
+  // Sort each row and squeeze out duplicates, compacting the array in place.
+  long write = 0;
+  for (int v = 0; v < vertexCount; v++)
+  {
+    long begin = offsets[v], end = offsets[v + 1];
+    qsort(neighbors + begin, (size_t)(end - begin), sizeof(int), compareInts);
+    offsets[v] = write;
+    for (long i = begin; i < end; i++)
+    {
+      if (i == begin || neighbors[i] != neighbors[i - 1])
+        neighbors[write++] = neighbors[i];
+    }
+  }
+  offsets[vertexCount] = write;
+  free(fill);
+
+  graph->vertexCount = vertexCount;
+  graph->edgeCount = write / 2;
+  graph->offsets = offsets;
+  graph->neighbors = neighbors;
+  return 0;
+}
+
+void graphBuilderInit(GraphBuilder *builder, int vertexCount)
+{
+  memset(builder, 0, sizeof(*builder));
+  builder->vertexCount = vertexCount > 0 ? vertexCount : 0;
+}
+
+int graphBuilderAddVertex(GraphBuilder *builder)
+{
+  return builder->vertexCount++;
+}
+
+int graphBuilderAddEdge(GraphBuilder *builder, int u, int v)
+{
+  if (u < 0 || v < 0)
+    return -1;
+  if (builder->edgeCount == builder->capacity)
+  {
+    long grown = builder->capacity ? builder->capacity * 2 : 1024;
+    int *from = realloc(builder->from, sizeof(int) * grown);
+    if (from == NULL)
+      return -1;
+    builder->from = from;
+    int *to = realloc(builder->to, sizeof(int) * grown);
+    if (to == NULL)
+      return -1;
+    builder->to = to;
+    builder->capacity = grown;
+  }
+  builder->from[builder->edgeCount] = u;
+  builder->to[builder->edgeCount] = v;
+  builder->edgeCount++;
+  if (u >= builder->vertexCount)
+    builder->vertexCount = u + 1;
+  if (v >= builder->vertexCount)
+    builder->vertexCount = v + 1;
+  return 0;
+}
+
+int graphBuilderFinish(GraphBuilder *builder, Graph *graph)
+{
+  int result = buildGraph(graph, builder->vertexCount, builder->from, builder->to, builder->edgeCount);
+  graphBuilderFree(builder);
+  return result;
+}
+
+void graphBuilderFree(GraphBuilder *builder)
+{
+  free(builder->from);
+  free(builder->to);
+  memset(builder, 0, sizeof(*builder));
+}
+
+int relabelByDegree(const Graph *graph, Graph *relabeled, int *newId)
+{
+  int n = graph->vertexCount;
+  memset(relabeled, 0, sizeof(*relabeled));
+  int maxDegree = 0;
+  for (int v = 0; v < n; v++)
+    maxDegree = graphDegree(graph, v) > maxDegree ? graphDegree(graph, v) : maxDegree;
+
+  // Counting sort on degree, highest first.
+  long *start = calloc((size_t)maxDegree + 2, sizeof(long));
+  int *order = malloc(sizeof(int) * (n ? n : 1));
+  int *ids = newId ? newId : malloc(sizeof(int) * (n ? n : 1));
+  long *offsets = malloc(sizeof(long) * ((size_t)n + 1));
+  int *neighbors = malloc(sizeof(int) * (graph->offsets[n] ? graph->offsets[n] : 1));
+  int ok = start && order && ids && offsets && neighbors;
+  if (ok)
+  {
+    for (int v = 0; v < n; v++)
+      start[maxDegree - graphDegree(graph, v) + 1]++;
+    for (int d = 0; d <= maxDegree; d++)
+      start[d + 1] += start[d];
+    for (int v = 0; v < n; v++)
+    {
+      int slot = (int)start[maxDegree - graphDegree(graph, v)]++;
+      order[slot] = v;
+      ids[v] = slot;
+    }
+
+    offsets[0] = 0;
+    for (int i = 0; i < n; i++)
+    {
+      int old = order[i];
+      long out = offsets[i];
+      for (long j = graph->offsets[old]; j < graph->offsets[old + 1]; j++)
+        neighbors[out++] = ids[graph->neighbors[j]];
+      qsort(neighbors + offsets[i], (size_t)(out - offsets[i]), sizeof(int), compareInts);
+      offsets[i + 1] = out;
+    }
+    relabeled->vertexCount = n;
+    relabeled->edgeCount = graph->edgeCount;
+    relabeled->offsets = offsets;
+    relabeled->neighbors = neighbors;
+  }
+  else
+  {
+    free(offsets);
+    free(neighbors);
+  }
+  free(start);
+  free(order);
+  if (ids != newId)
+    free(ids);
+  return ok ? 0 : -1;
+}
+
+int loadGraph(const char *path, Graph *graph)
+{
+  memset(graph, 0, sizeof(*graph));
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+    return -1;
+
+  char line[MAX_GRAPH_LINE];
+  GraphBuilder builder;
+  graphBuilderInit(&builder, 0);
+  int vertexCount = -1;  // from the DIMACS header, if any
+  int dimacs = 0, ok = 1;
+
+  while (ok && fgets(line, sizeof(line), file))
+  {
+    char *text = line;
+    while (*text == ' ' || *text == '\t')
+      text++;
+    int u, v;
+    if (*text == 'c' || *text == '#' || *text == '%' || *text == '\n' || *text == '\r' || *text == '\0')
+      continue;
+    if (*text == 'p')
+    {
+      long edges;
+      ok = !dimacs && sscanf(text, "p %*s %d %ld", &vertexCount, &edges) == 2 && vertexCount >= 0;
+      builder.vertexCount = vertexCount;
+      dimacs = 1;
+    }
+    else if (*text == 'e')
+    {
+      ok = dimacs && sscanf(text, "e %d %d", &u, &v) == 2 && u >= 1 && v >= 1 &&
+           u <= vertexCount && v <= vertexCount &&
+           graphBuilderAddEdge(&builder, u - 1, v - 1) == 0;
+    }
+    else
+    {
+      ok = !dimacs && sscanf(text, "%d %d", &u, &v) == 2 && u >= 0 && v >= 0 &&
+           graphBuilderAddEdge(&builder, u, v) == 0;
+    }
+  }
+  fclose(file);
+
+  if (!ok)
+  {
+    graphBuilderFree(&builder);
+    return -1;
+  }
+  return graphBuilderFinish(&builder, graph);
+}
+
+void freeGraph(Graph *graph)
+{
+  free(graph->offsets);
+  free(graph->neighbors);
+  memset(graph, 0, sizeof(*graph));
+}
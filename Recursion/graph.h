@@ -0,0 +1,56 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+// Undirected simple graph in compressed-sparse-row form: the neighbors of v
+// are neighbors[offsets[v]] .. neighbors[offsets[v + 1] - 1], sorted, with
+// every edge stored in both directions and no self loops or duplicates.
+typedef struct
+{
+  int vertexCount;
+  long edgeCount;  // undirected edges (half the neighbor array)
+  long *offsets;   // vertexCount + 1 entries
+  int *neighbors;
+} Graph;
+
+// Builds a graph from edgeCount (from[i], to[i]) pairs on vertexCount vertices.
+// Self loops and repeated edges are dropped. Returns 0, or -1 on bad input.
+int buildGraph(Graph *graph, int vertexCount, const int *from, const int *to, long edgeCount);
+
+// Loads a DIMACS graph ("p edge N M" then "e u v", 1-based) or a plain edge
+// list ("u v" per line, 0-based, '#' or '%' comments). Returns 0 or -1.
+int loadGraph(const char *path, Graph *graph);
+
+void freeGraph(Graph *graph);
+
+// Collects edges one at a time, then packs them into a Graph.
+typedef struct
+{
+  int vertexCount;
+  long edgeCount, capacity;
+  int *from, *to;
+} GraphBuilder;
+
+void graphBuilderInit(GraphBuilder *builder, int vertexCount);
+
+// Adds a vertex and returns its number.
+int graphBuilderAddVertex(GraphBuilder *builder);
+
+// Adds edge u-v, growing the vertex count to cover both ends. Returns 0 or -1.
+int graphBuilderAddEdge(GraphBuilder *builder, int u, int v);
+
+// Builds the graph (see buildGraph) and empties the builder. Returns 0 or -1.
+int graphBuilderFinish(GraphBuilder *builder, Graph *graph);
+
+void graphBuilderFree(GraphBuilder *builder);
+
+// Renumbers vertices by decreasing degree (ties keep their order) so the
+// busiest vertices and their rows sit together in memory. Writes the new
+// number of each old vertex to newId if it is not NULL. Returns 0 or -1.
+int relabelByDegree(const Graph *graph, Graph *relabeled, int *newId);
+
+static inline int graphDegree(const Graph *graph, int vertex)
+{
+  return (int)(graph->offsets[vertex + 1] - graph->offsets[vertex]);
+}
+
+#endif
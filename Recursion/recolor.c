@@ -0,0 +1,598 @@
+// Keeps a graph coloring valid under small edits without re-solving.
+// Build with: ./build.sh recolor, or
+//   clang -O2 recolor.c dsatur.c graph.c "../Space World/parallel.c" -DDSATUR_NO_MAIN -pthread -o recolor
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "recolor.h"
+#include "dsatur.h"
+
+#define KEMPE_CHAIN_LIMIT 4096   // vertices one chain swap may touch
+#define LOCAL_NODE_LIMIT 100000  // search nodes per neighborhood re-solve
+#define FULL_NODE_LIMIT 10000000 // search nodes per whole-graph solve
+
+// Neighborhood sizes tried, in vertices, before falling back to a full solve.
+static const int neighborhoodSizes[] = { 16, 64, 256, 1024 };
+
+static uint64_t allColors(const DynamicColoring *dc)
+{
+  return dc->maxColors >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << dc->maxColors) - 1;
+}
+
+static uint64_t colorBit(int color)
+{
+  return (uint64_t)1 << (color - 1);
+}
+
+static int nextStamp(DynamicColoring *dc)
+{
+  if (dc->stamp == INT_MAX)
+  {
+    memset(dc->mark, 0, sizeof(int) * dc->capacity);
+    dc->stamp = 0;
+  }
+  return ++dc->stamp;
+}
+
+// Grows the per-vertex arrays to hold count vertices.
+static int reserveVertices(DynamicColoring *dc, int count)
+{
+  if (count <= dc->capacity)
+    return 0;
+  int capacity = dc->capacity ? dc->capacity : 16;
+  while (capacity < count)
+    capacity *= 2;
+
+  int *colors = realloc(dc->colors, sizeof(int) * capacity);
+  if (colors)
+    dc->colors = colors;
+  int **adjacency = realloc(dc->adjacency, sizeof(int *) * capacity);
+  if (adjacency)
+    dc->adjacency = adjacency;
+  int *degree = realloc(dc->degree, sizeof(int) * capacity);
+  if (degree)
+    dc->degree = degree;
+  int *adjacencyCapacity = realloc(dc->adjacencyCapacity, sizeof(int) * capacity);
+  if (adjacencyCapacity)
+    dc->adjacencyCapacity = adjacencyCapacity;
+  unsigned char *alive = realloc(dc->alive, capacity);
+  if (alive)
+    dc->alive = alive;
+  int *mark = realloc(dc->mark, sizeof(int) * capacity);
+  if (mark)
+    dc->mark = mark;
+  int *queue = realloc(dc->queue, sizeof(int) * capacity);
+  if (queue)
+    dc->queue = queue;
+  int *slot = realloc(dc->slot, sizeof(int) * capacity);
+  if (slot)
+    dc->slot = slot;
+  if (!(colors && adjacency && degree && adjacencyCapacity && alive && mark && queue && slot))
+    return -1;
+
+  for (int v = dc->capacity; v < capacity; v++)
+  {
+    colors[v] = 0;
+    adjacency[v] = NULL;
+    degree[v] = adjacencyCapacity[v] = 0;
+    alive[v] = 0;
+    mark[v] = 0;
+  }
+  dc->capacity = capacity;
+  return 0;
+}
+
+static int appendNeighbor(DynamicColoring *dc, int vertex, int neighbor)
+{
+  if (dc->degree[vertex] == dc->adjacencyCapacity[vertex])
+  {
+    int capacity = dc->adjacencyCapacity[vertex] ? dc->adjacencyCapacity[vertex] * 2 : 4;
+    int *list = realloc(dc->adjacency[vertex], sizeof(int) * capacity);
+    if (list == NULL)
+      return -1;
+    dc->adjacency[vertex] = list;
+    dc->adjacencyCapacity[vertex] = capacity;
+  }
+  dc->adjacency[vertex][dc->degree[vertex]++] = neighbor;
+  return 0;
+}
+
+static int dropNeighbor(DynamicColoring *dc, int vertex, int neighbor)
+{
+  int *list = dc->adjacency[vertex];
+  for (int i = 0; i < dc->degree[vertex]; i++)
+  {
+    if (list[i] == neighbor)
+    {
+      list[i] = list[--dc->degree[vertex]];
+      return 0;
+    }
+  }
+  return -1;
+}
+
+static int hasEdge(const DynamicColoring *dc, int u, int v)
+{
+  if (dc->degree[u] > dc->degree[v])
+  {
+    int t = u;
+    u = v;
+    v = t;
+  }
+  for (int i = 0; i < dc->degree[u]; i++)
+  {
+    if (dc->adjacency[u][i] == v)
+      return 1;
+  }
+  return 0;
+}
+
+static int isVertex(const DynamicColoring *dc, int v)
+{
+  return v >= 0 && v < dc->vertexCount && dc->alive[v];
+}
+
+static uint64_t neighborColors(const DynamicColoring *dc, int vertex)
+{
+  uint64_t used = 0;
+  for (int i = 0; i < dc->degree[vertex]; i++)
+  {
+    int color = dc->colors[dc->adjacency[vertex][i]];
+    if (color != 0)
+      used |= colorBit(color);
+  }
+  return used;
+}
+
+// --- Repair strategies; each leaves vertex colored on success ---
+
+static int tryFreeColor(DynamicColoring *dc, int vertex)
+{
+  uint64_t free = allColors(dc) & ~neighborColors(dc, vertex);
+  if (free == 0)
+    return 0;
+  dc->colors[vertex] = __builtin_ctzll(free) + 1;
+  return 1;
+}
+
+// Swaps colors c and d on the chains of c/d vertices that start at vertex's
+// c-colored neighbors, which frees c for vertex. Fails, changing nothing, if
+// a chain reaches a d-colored neighbor (it would turn c) or grows too long.
+static int swapKempeChain(DynamicColoring *dc, int vertex, int c, int d)
+{
+  int stamp = nextStamp(dc);
+  int head = 0, tail = 0;
+  dc->mark[vertex] = stamp;
+  for (int i = 0; i < dc->degree[vertex]; i++)
+  {
+    int u = dc->adjacency[vertex][i];
+    if (dc->colors[u] == c && dc->mark[u] != stamp)
+    {
+      dc->mark[u] = stamp;
+      dc->queue[tail++] = u;
+    }
+  }
+  while (head < tail)
+  {
+    int w = dc->queue[head++];
+    for (int i = 0; i < dc->degree[w]; i++)
+    {
+      int y = dc->adjacency[w][i];
+      if (dc->mark[y] == stamp || (dc->colors[y] != c && dc->colors[y] != d))
+        continue;
+      if (tail == KEMPE_CHAIN_LIMIT)
+        return 0;
+      dc->mark[y] = stamp;
+      dc->queue[tail++] = y;
+    }
+  }
+  for (int i = 0; i < dc->degree[vertex]; i++)
+  {
+    int u = dc->adjacency[vertex][i];
+    if (dc->colors[u] == d && dc->mark[u] == stamp)
+      return 0;
+  }
+  for (int i = 0; i < tail; i++)
+  {
+    int w = dc->queue[i];
+    dc->colors[w] = dc->colors[w] == c ? d : c;
+  }
+  return 1;
+}
+
+static int tryKempe(DynamicColoring *dc, int vertex)
+{
+  for (int c = 1; c <= dc->maxColors; c++)
+  {
+    for (int d = 1; d <= dc->maxColors; d++)
+    {
+      if (d != c && swapKempeChain(dc, vertex, c, d))
+      {
+        dc->colors[vertex] = c;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+// Re-solves the size vertices nearest to vertex with everything outside
+// fixed. Returns 1 on success, 0 if it failed, and -1 if the neighborhood
+// is vertex's whole component and it has no coloring at all.
+static int tryNeighborhood(DynamicColoring *dc, int vertex, int size)
+{
+  int stamp = nextStamp(dc);
+  int count = 0;
+  dc->mark[vertex] = stamp;
+  dc->slot[vertex] = count;
+  dc->queue[count++] = vertex;
+  for (int head = 0; head < count && count < size; head++)
+  {
+    int w = dc->queue[head];
+    for (int i = 0; i < dc->degree[w] && count < size; i++)
+    {
+      int y = dc->adjacency[w][i];
+      if (dc->mark[y] != stamp)
+      {
+        dc->mark[y] = stamp;
+        dc->slot[y] = count;
+        dc->queue[count++] = y;
+      }
+    }
+  }
+
+  GraphBuilder builder;
+  graphBuilderInit(&builder, count);
+  uint64_t *domains = malloc(sizeof(uint64_t) * count);
+  int *colors = malloc(sizeof(int) * count);
+  int closed = 1, ok = domains && colors;
+  for (int i = 0; ok && i < count; i++)
+  {
+    int w = dc->queue[i];
+    domains[i] = allColors(dc);
+    for (int j = 0; ok && j < dc->degree[w]; j++)
+    {
+      int y = dc->adjacency[w][j];
+      if (dc->mark[y] == stamp)
+      {
+        if (i < dc->slot[y])
+          ok = graphBuilderAddEdge(&builder, i, dc->slot[y]) == 0;
+      }
+      else
+      {
+        closed = 0;
+        if (dc->colors[y] != 0)
+          domains[i] &= ~colorBit(dc->colors[y]);
+      }
+    }
+  }
+
+  Graph local;
+  int result = 0;
+  if (ok && graphBuilderFinish(&builder, &local) == 0)
+  {
+    int solved = dsaturColorRestricted(&local, dc->maxColors, domains, LOCAL_NODE_LIMIT, colors, NULL);
+    if (solved == 1)
+    {
+      for (int i = 0; i < count; i++)
+        dc->colors[dc->queue[i]] = colors[i];
+      result = 1;
+    }
+    else if (solved == 0 && closed)
+      result = -1;
+    freeGraph(&local);
+  }
+  graphBuilderFree(&builder);
+  free(domains);
+  free(colors);
+  return result;
+}
+
+// Re-solves the whole graph within FULL_NODE_LIMIT search nodes. Returns 1
+// on success, 0 if no coloring exists and -1 if the budget ran out or memory
+// did, leaving the coloring as it was.
+static int tryFullSolve(DynamicColoring *dc)
+{
+  GraphBuilder builder;
+  graphBuilderInit(&builder, dc->vertexCount);
+  int ok = 1;
+  for (int v = 0; ok && v < dc->vertexCount; v++)
+  {
+    for (int i = 0; ok && i < dc->degree[v]; i++)
+    {
+      if (v < dc->adjacency[v][i])
+        ok = graphBuilderAddEdge(&builder, v, dc->adjacency[v][i]) == 0;
+    }
+  }
+  Graph graph;
+  if (!ok || graphBuilderFinish(&builder, &graph) != 0)
+  {
+    graphBuilderFree(&builder);
+    return -1;
+  }
+  int *colors = malloc(sizeof(int) * (dc->vertexCount ? dc->vertexCount : 1));
+  int solved = colors ? dsaturColor(&graph, dc->maxColors, FULL_NODE_LIMIT, colors, NULL) : -1;
+  for (int v = 0; solved == 1 && v < dc->vertexCount; v++)
+    dc->colors[v] = dc->alive[v] ? colors[v] : 0;
+  free(colors);
+  freeGraph(&graph);
+  return solved;
+}
+
+// Colors every uncolored vertex with its lowest free color, if it has one.
+// The fallback when a full solve gives up.
+static void colorGreedily(DynamicColoring *dc)
+{
+  for (int v = 0; v < dc->vertexCount; v++)
+  {
+    if (dc->alive[v] && dc->colors[v] == 0)
+      tryFreeColor(dc, v);
+  }
+}
+
+// Gives vertex a color consistent with its neighbors, changing as little of
+// the rest of the coloring as it can. Returns 1, or 0 with vertex uncolored
+// and the rest of the coloring as the Kempe and local repairs left it.
+static int repairVertex(DynamicColoring *dc, int vertex)
+{
+  dc->colors[vertex] = 0;
+  if (tryFreeColor(dc, vertex))
+  {
+    dc->stats.freeColor++;
+    return 1;
+  }
+  if (tryKempe(dc, vertex))
+  {
+    dc->stats.kempe++;
+    return 1;
+  }
+  for (size_t i = 0; i < sizeof(neighborhoodSizes) / sizeof(neighborhoodSizes[0]); i++)
+  {
+    int result = tryNeighborhood(dc, vertex, neighborhoodSizes[i]);
+    if (result == 1)
+    {
+      dc->stats.local++;
+      return 1;
+    }
+    if (result == -1)
+    {
+      dc->stats.failed++;
+      return 0;
+    }
+  }
+  int result = tryFullSolve(dc);
+  if (result == 1)
+  {
+    dc->stats.full++;
+    return 1;
+  }
+  dc->colors[vertex] = 0;
+  if (result == 0)
+    dc->stats.failed++;
+  else
+    dc->stats.gaveUp++;
+  return 0;
+}
+
+// --- Public API ---
+
+int dynamicColoringInit(DynamicColoring *dc, const Graph *graph, int maxColors, const int *colors)
+{
+  memset(dc, 0, sizeof(*dc));
+  if (maxColors < 1 || maxColors > DSATUR_MAX_COLORS)
+    return -1;
+  dc->maxColors = maxColors;
+  int n = graph->vertexCount;
+  if (reserveVertices(dc, n) != 0)
+    return -1;
+  dc->vertexCount = n;
+  for (int v = 0; v < n; v++)
+  {
+    dc->alive[v] = 1;
+    for (long i = graph->offsets[v]; i < graph->offsets[v + 1]; i++)
+    {
+      if (appendNeighbor(dc, v, graph->neighbors[i]) != 0)
+        return -1;
+    }
+  }
+
+  if (colors == NULL)
+  {
+    if (n == 0)
+      return 1;
+    int solved = tryFullSolve(dc);
+    if (solved != -1)
+      return solved;
+    // Out of budget: keep what a greedy pass can color.
+    colorGreedily(dc);
+    int result = 1;
+    for (int v = 0; v < n; v++)
+    {
+      if (dc->colors[v] == 0)
+      {
+        dc->stats.gaveUp++;
+        result = 0;
+      }
+    }
+    return result;
+  }
+
+  // Take the given coloring, repairing any vertex that clashes with an
+  // earlier neighbor or is out of range.
+  int result = 1;
+  for (int v = 0; v < n; v++)
+  {
+    dc->colors[v] = colors[v] >= 1 && colors[v] <= maxColors ? colors[v] : 0;
+    int clash = dc->colors[v] == 0;
+    for (int i = 0; i < dc->degree[v] && !clash; i++)
+      clash = dc->adjacency[v][i] < v && dc->colors[dc->adjacency[v][i]] == dc->colors[v];
+    if (clash && !repairVertex(dc, v))
+      result = 0;
+  }
+  return result;
+}
+
+void dynamicColoringFree(DynamicColoring *dc)
+{
+  for (int v = 0; v < dc->capacity; v++)
+    free(dc->adjacency[v]);
+  free(dc->colors);
+  free(dc->adjacency);
+  free(dc->degree);
+  free(dc->adjacencyCapacity);
+  free(dc->alive);
+  free(dc->mark);
+  free(dc->queue);
+  free(dc->slot);
+  memset(dc, 0, sizeof(*dc));
+}
+
+int dynamicAddVertex(DynamicColoring *dc)
+{
+  if (reserveVertices(dc, dc->vertexCount + 1) != 0)
+    return -1;
+  int vertex = dc->vertexCount++;
+  dc->alive[vertex] = 1;
+  dc->colors[vertex] = 1;
+  return vertex;
+}
+
+int dynamicRemoveVertex(DynamicColoring *dc, int vertex)
+{
+  if (!isVertex(dc, vertex))
+    return -1;
+  int degree = dc->degree[vertex];
+  for (int i = 0; i < degree; i++)
+    dropNeighbor(dc, dc->adjacency[vertex][i], vertex);
+  dc->degree[vertex] = 0;
+  dc->alive[vertex] = 0;
+  dc->colors[vertex] = 0;
+  // One constraint fewer: neighbors left uncolored may fit now. The list
+  // itself is still allocated.
+  for (int i = 0; i < degree; i++)
+  {
+    int neighbor = dc->adjacency[vertex][i];
+    if (dc->colors[neighbor] == 0)
+      repairVertex(dc, neighbor);
+  }
+  return 0;
+}
+
+int dynamicAddEdge(DynamicColoring *dc, int u, int v)
+{
+  if (!isVertex(dc, u) || !isVertex(dc, v) || u == v)
+    return -1;
+  if (!hasEdge(dc, u, v))
+  {
+    if (appendNeighbor(dc, u, v) != 0)
+      return -1;
+    if (appendNeighbor(dc, v, u) != 0)
+    {
+      dropNeighbor(dc, u, v);
+      return -1;
+    }
+  }
+  // The end with fewer neighbors usually has a free color or a short chain.
+  if (dc->colors[u] != 0 && dc->colors[u] == dc->colors[v])
+    repairVertex(dc, dc->degree[u] <= dc->degree[v] ? u : v);
+  return dc->colors[u] != 0 && dc->colors[v] != 0;
+}
+
+int dynamicRemoveEdge(DynamicColoring *dc, int u, int v)
+{
+  if (!isVertex(dc, u) || !isVertex(dc, v) || dropNeighbor(dc, u, v) != 0)
+    return -1;
+  dropNeighbor(dc, v, u);
+  if (dc->colors[u] == 0)
+    repairVertex(dc, u);
+  if (dc->colors[v] == 0)
+    repairVertex(dc, v);
+  return 0;
+}
+
+#ifndef RECOLOR_NO_MAIN
+#include <time.h>
+
+static double nowSeconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int countConflicts(const DynamicColoring *dc)
+{
+  int conflicts = 0;
+  for (int v = 0; v < dc->vertexCount; v++)
+  {
+    if (!dc->alive[v])
+      continue;
+    if (dc->colors[v] == 0)
+      conflicts++;
+    for (int i = 0; i < dc->degree[v]; i++)
+      conflicts += dc->colors[dc->adjacency[v][i]] == dc->colors[v] && dc->colors[v] != 0;
+  }
+  return conflicts;
+}
+
+// Applies random edge insertions and deletions to a colored graph and
+// reports how each conflict was repaired.
+int main(int argc, char *argv[])
+{
+  if (argc < 3)
+  {
+    printf("Usage: %s <graph file> <colors> [edits]\n", argv[0]);
+    return 1;
+  }
+  Graph graph;
+  if (loadGraph(argv[1], &graph) != 0 || graph.vertexCount < 2)
+  {
+    printf("Could not load graph from %s\n", argv[1]);
+    return 1;
+  }
+  int maxColors = atoi(argv[2]);
+  long edits = argc > 3 ? atol(argv[3]) : 1000;
+
+  DynamicColoring dc;
+  double start = nowSeconds();
+  int result = dynamicColoringInit(&dc, &graph, maxColors, NULL);
+  printf("Initial solve: %s in %.3f s\n", result == 1 ? "colored" : "no coloring", nowSeconds() - start);
+  if (result != 1)
+    return 2;
+
+  srand(1);
+  start = nowSeconds();
+  long added = 0, removed = 0, failed = 0;
+  for (long e = 0; e < edits; e++)
+  {
+    int u = rand() % dc.vertexCount;
+    if (rand() % 2 == 0 && dc.degree[u] > 0)
+    {
+      dynamicRemoveEdge(&dc, u, dc.adjacency[u][rand() % dc.degree[u]]);
+      removed++;
+    }
+    else
+    {
+      int v = rand() % dc.vertexCount;
+      if (u != v)
+      {
+        failed += dynamicAddEdge(&dc, u, v) == 0;
+        added++;
+      }
+    }
+  }
+  double seconds = nowSeconds() - start;
+  printf("%ld edits (%ld added, %ld removed) in %.3f s, %.2f us/edit\n", edits, added, removed, seconds,
+         edits ? seconds * 1e6 / edits : 0.0);
+  printf("Repairs: free color %ld, Kempe chain %ld, local %ld, full %ld, failed %ld, gave up %ld\n",
+         dc.stats.freeColor, dc.stats.kempe, dc.stats.local, dc.stats.full, dc.stats.failed,
+         dc.stats.gaveUp);
+  printf("Conflicts left: %d\n", countConflicts(&dc));
+
+  dynamicColoringFree(&dc);
+  freeGraph(&graph);
+  return failed ? 2 : 0;
+}
+#endif
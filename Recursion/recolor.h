@@ -0,0 +1,61 @@
+#ifndef RECOLOR_H
+#define RECOLOR_H
+
+#include "graph.h"
+
+typedef struct
+{
+  long freeColor;  // conflicts fixed by picking a free color
+  long kempe;      // ... by swapping a two-color Kempe chain
+  long local;      // ... by re-solving a small neighborhood
+  long full;       // ... by re-solving the whole graph
+  long failed;     // vertices left uncolored: no coloring exists
+  long gaveUp;     // vertices left uncolored: the full solve ran out of budget
+} RecolorStats;
+
+// A coloring kept valid while the graph changes. Adjacency is stored per
+// vertex so edges can come and go; vertex numbers never change.
+typedef struct
+{
+  int vertexCount;     // numbers handed out, removed vertices included
+  int capacity;
+  int maxColors;
+  int *colors;         // 0 = uncolored (removed, or no coloring exists)
+  int **adjacency;
+  int *degree;
+  int *adjacencyCapacity;
+  unsigned char *alive;
+  int *mark;           // scratch for searches, compared against stamp
+  int stamp;
+  int *queue;
+  int *slot;           // neighborhood numbering for local re-solves
+  RecolorStats stats;
+} DynamicColoring;
+
+// Takes graph and its coloring (colors 1..maxColors, maxColors <= 64). With
+// colors NULL the graph is colored from scratch, by a bounded search that
+// falls back to greedy colors if it runs out. Returns 1, 0 if no coloring
+// was found (vertices are then left uncolored), or -1 on bad input.
+int dynamicColoringInit(DynamicColoring *dc, const Graph *graph, int maxColors, const int *colors);
+
+void dynamicColoringFree(DynamicColoring *dc);
+
+// Adds an isolated vertex, colored 1, and returns its number (-1 on failure).
+int dynamicAddVertex(DynamicColoring *dc);
+
+// Removes vertex and its edges; its uncolored neighbors get another repair
+// attempt. Returns 0, or -1 if it does not exist.
+int dynamicRemoveVertex(DynamicColoring *dc, int vertex);
+
+// Adds edge u-v and repairs the coloring if both ends share a color: first a
+// free color, then Kempe-chain swaps, then bounded backtracking over growing
+// neighborhoods, and only then a full solve with a node budget. Returns 1 if
+// both ends are colored afterwards, 0 if one is left uncolored (no maxColors
+// coloring exists, the budget ran out, or it already was), or -1 on bad input.
+int dynamicAddEdge(DynamicColoring *dc, int u, int v);
+
+// Removes edge u-v. Never creates a conflict; an uncolored end gets another
+// repair attempt. Returns 0, or -1 if the edge is absent.
+int dynamicRemoveEdge(DynamicColoring *dc, int u, int v);
+
+#endif
@@ -0,0 +1,296 @@
+#include "approach.h"
+#include "destinations.h"
+#include "ephemeris.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI 3.141592653589793
+#define BODIES_PER_TASK 64
+#define STEPS_PER_RADIAN 8       // leaves per radian of the body's fastest turn
+#define ROOT_TOLERANCE 1e-9      // days
+#define MAX_ROOT_ITERATIONS 100
+
+// Bodies sorted by the inner radius of their orbit, so the ones that can come
+// near a path are a contiguous run found by binary search. Rebuilt whenever
+// the catalog changes.
+typedef struct {
+    unsigned generation;  // catalog the index was built for (getDestinationGeneration)
+    int built;
+    int count;
+    int *order;           // body indices by inner radius
+    double *inner;        // inner radius of order[k]
+    double *outer;        // outer radius of order[k]
+    double widest;        // largest outer - inner
+    double *speed;        // fastest speed of each body, by body index (AU/day)
+    double *turnTime;     // shortest time each body takes to turn one radian
+} AnnulusIndex;
+
+static AnnulusIndex annulusIndex;
+
+// Bodies found for chunk c of the candidate list.
+typedef struct {
+    CloseApproach *items;
+    int count, capacity;
+} ApproachList;
+
+typedef struct {
+    const ShipPath *path;
+    BodySet bodies;
+    double threshold;
+    double shipSpeed;
+    const int *candidates;
+    ApproachList *lists;
+    int failed;
+} SweepJob;
+
+// One point of the search: the ship-body distance and half its derivative.
+typedef struct {
+    double t, distance, rate;
+} Sample;
+
+// Inner radius of each body, by body index, while the index is sorted.
+static const double *sortRadii;
+
+static int compareInner(const void *a, const void *b) {
+    double ia = sortRadii[*(const int *)a], ib = sortRadii[*(const int *)b];
+    return (ia > ib) - (ia < ib);
+}
+
+static int buildAnnulusIndex(BodySet bodies) {
+    AnnulusIndex *index = &annulusIndex;
+    free(index->order);
+    free(index->inner);
+    free(index->outer);
+    free(index->speed);
+    free(index->turnTime);
+    memset(index, 0, sizeof(*index));
+    int n = bodies.count;
+    double *inner = malloc(sizeof(double) * (n + 1)), *outer = malloc(sizeof(double) * (n + 1));
+    index->order = malloc(sizeof(int) * (n + 1));
+    index->inner = malloc(sizeof(double) * (n + 1));
+    index->outer = malloc(sizeof(double) * (n + 1));
+    index->speed = malloc(sizeof(double) * (n + 1));
+    index->turnTime = malloc(sizeof(double) * (n + 1));
+    if (!inner || !outer || !index->order || !index->inner || !index->outer || !index->speed ||
+        !index->turnTime) {
+        free(inner);
+        free(outer);
+        return -1;
+    }
+
+    for (int b = 0; b < n; b++) {
+        double a = bodies.orbitRadius[b];
+        double e = bodies.orbits.eccentricity ? bodies.orbits.eccentricity[b] : 0.0;
+        // Speed and angular rate both peak at periapsis.
+        double meanMotion = 2 * PI / bodies.orbitalPeriod[b];
+        inner[b] = a * (1.0 - e);
+        outer[b] = a * (1.0 + e);
+        index->order[b] = b;
+        index->speed[b] = meanMotion * a * sqrt((1.0 + e) / (1.0 - e));
+        index->turnTime[b] = pow(1.0 - e, 1.5) / (sqrt(1.0 + e) * meanMotion);
+        index->widest = fmax(index->widest, outer[b] - inner[b]);
+    }
+    sortRadii = inner;
+    qsort(index->order, n, sizeof(int), compareInner);
+    for (int k = 0; k < n; k++) {
+        index->inner[k] = inner[index->order[k]];
+        index->outer[k] = outer[index->order[k]];
+    }
+    free(inner);
+    free(outer);
+    index->generation = getDestinationGeneration();
+    index->built = 1;
+    index->count = n;
+    return 0;
+}
+
+// First k with index->inner[k] > value.
+static int upperBound(double value) {
+    int lo = 0, hi = annulusIndex.count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (annulusIndex.inner[mid] <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static Sample sampleAt(const SweepJob *job, int body, double t) {
+    const ShipPath *path = job->path;
+    Vector3D velocity;
+    Vector3D position = computeBodyPosition(job->bodies, body, t, &velocity);
+    double dt = t - path->startTime;
+    double dx = path->start.x + path->velocity.x * dt - position.x;
+    double dy = path->start.y + path->velocity.y * dt - position.y;
+    double dz = path->start.z + path->velocity.z * dt - position.z;
+    Sample s = { t, sqrt(dx * dx + dy * dy + dz * dz),
+                 dx * (path->velocity.x - velocity.x) + dy * (path->velocity.y - velocity.y) +
+                 dz * (path->velocity.z - velocity.z) };
+    return s;
+}
+
+static void recordApproach(SweepJob *job, ApproachList *list, int body, Sample s) {
+    if (s.distance > job->threshold)
+        return;
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? 2 * list->capacity : 16;
+        CloseApproach *grown = realloc(list->items, sizeof(CloseApproach) * capacity);
+        if (grown == NULL) {
+            job->failed = 1;
+            return;
+        }
+        list->items = grown;
+        list->capacity = capacity;
+    }
+    CloseApproach *approach = &list->items[list->count++];
+    approach->body = body;
+    approach->time = s.t;
+    approach->distance = s.distance;
+}
+
+// The derivative changes sign from - to + in [a, b]: locate the minimum with
+// the Illinois variant of regula falsi, which keeps the bracket and converges
+// superlinearly.
+static Sample refineMinimum(const SweepJob *job, int body, Sample a, Sample b) {
+    int side = 0;
+    double ra = a.rate, rb = b.rate;
+    Sample m = a;
+    for (int k = 0; k < MAX_ROOT_ITERATIONS && b.t - a.t > ROOT_TOLERANCE; k++) {
+        double t = (a.t * rb - b.t * ra) / (rb - ra);
+        if (!(t > a.t && t < b.t))
+            t = 0.5 * (a.t + b.t);
+        m = sampleAt(job, body, t);
+        if (m.rate < 0.0) {
+            a = m;
+            ra = m.rate;
+            if (side == -1)
+                rb *= 0.5;
+            side = -1;
+        } else {
+            b = m;
+            rb = m.rate;
+            if (side == 1)
+                ra *= 0.5;
+            side = 1;
+        }
+    }
+    return a.distance < b.distance ? a : b;
+}
+
+// Splits [a, b] until the distance provably stays above the threshold or the
+// interval is short enough to hold at most one minimum. The distance changes
+// no faster than lipschitz AU/day, so it is at least
+// (a.distance + b.distance - lipschitz * (b.t - a.t)) / 2 in between.
+static void searchInterval(SweepJob *job, ApproachList *list, int body, Sample a, Sample b,
+                           double lipschitz, double minStep) {
+    if (0.5 * (a.distance + b.distance - lipschitz * (b.t - a.t)) > job->threshold)
+        return;
+    if (b.t - a.t <= minStep) {
+        if (a.rate < 0.0 && b.rate >= 0.0)
+            recordApproach(job, list, body, refineMinimum(job, body, a, b));
+        return;
+    }
+    Sample m = sampleAt(job, body, 0.5 * (a.t + b.t));
+    searchInterval(job, list, body, a, m, lipschitz, minStep);
+    searchInterval(job, list, body, m, b, lipschitz, minStep);
+}
+
+static void sweepBodies(void *context, int begin, int end) {
+    SweepJob *job = context;
+    ApproachList *list = &job->lists[begin / BODIES_PER_TASK];
+    const ShipPath *path = job->path;
+    for (int k = begin; k < end; k++) {
+        int body = job->candidates[k];
+        double lipschitz = job->shipSpeed + annulusIndex.speed[body];
+        double minStep = annulusIndex.turnTime[body] / STEPS_PER_RADIAN;
+        Sample first = sampleAt(job, body, path->startTime);
+        Sample last = sampleAt(job, body, path->endTime);
+        if (first.rate >= 0.0)
+            recordApproach(job, list, body, first);
+        searchInterval(job, list, body, first, last, lipschitz, minStep);
+        if (last.rate < 0.0)
+            recordApproach(job, list, body, last);
+    }
+}
+
+static int compareApproaches(const void *a, const void *b) {
+    const CloseApproach *x = a, *y = b;
+    if (x->time != y->time)
+        return (x->time > y->time) - (x->time < y->time);
+    return (x->body > y->body) - (x->body < y->body);
+}
+
+int findCloseApproaches(const ShipPath *path, double threshold, int threads,
+                        CloseApproach *approaches, int maxApproaches) {
+    if (!(path->endTime >= path->startTime) || !(threshold >= 0.0) || maxApproaches < 0)
+        return -1;
+    BodySet bodies = getDestinationBodySet();
+    if (!annulusIndex.built || annulusIndex.generation != getDestinationGeneration() ||
+        annulusIndex.count != bodies.count) {
+        if (buildAnnulusIndex(bodies) != 0)
+            return -1;
+    }
+
+    // The path's distance from the Sun ranges over [nearest, farthest].
+    const Vector3D *p = &path->start, *v = &path->velocity;
+    double duration = path->endTime - path->startTime;
+    double speedSquared = v->x * v->x + v->y * v->y + v->z * v->z;
+    double closest = speedSquared > 0.0 ? -(p->x * v->x + p->y * v->y + p->z * v->z) / speedSquared : 0.0;
+    closest = fmin(fmax(closest, 0.0), duration);
+    Vector3D end = { p->x + v->x * duration, p->y + v->y * duration, p->z + v->z * duration };
+    Vector3D near = { p->x + v->x * closest, p->y + v->y * closest, p->z + v->z * closest };
+    Vector3D sun = { 0.0, 0.0, 0.0 };
+    double nearest = calculateDistance(sun, near);
+    double farthest = fmax(calculateDistance(sun, *p), calculateDistance(sun, end));
+
+    // Candidates: inner <= farthest + threshold and outer >= nearest - threshold.
+    int from = upperBound(nearest - threshold - annulusIndex.widest - 1e-12);
+    int to = upperBound(farthest + threshold);
+    int *candidates = malloc(sizeof(int) * (to - from + 1));
+    if (candidates == NULL)
+        return -1;
+    int count = 0;
+    for (int k = from; k < to; k++) {
+        if (annulusIndex.outer[k] >= nearest - threshold)
+            candidates[count++] = annulusIndex.order[k];
+    }
+
+    SweepJob job;
+    job.path = path;
+    job.bodies = bodies;
+    job.threshold = threshold;
+    job.shipSpeed = sqrt(speedSquared);
+    job.candidates = candidates;
+    job.failed = 0;
+    int chunks = (count + BODIES_PER_TASK - 1) / BODIES_PER_TASK;
+    job.lists = calloc(chunks + 1, sizeof(ApproachList));
+    if (job.lists == NULL) {
+        free(candidates);
+        return -1;
+    }
+    parallelFor(count, BODIES_PER_TASK, threads, sweepBodies, &job);
+
+    int found = 0;
+    for (int c = 0; c < chunks; c++)
+        found += job.lists[c].count;
+    CloseApproach *all = malloc(sizeof(CloseApproach) * (found + 1));
+    if (all != NULL) {
+        int k = 0;
+        for (int c = 0; c < chunks; c++) {
+            memcpy(all + k, job.lists[c].items, sizeof(CloseApproach) * job.lists[c].count);
+            k += job.lists[c].count;
+        }
+        qsort(all, found, sizeof(CloseApproach), compareApproaches);
+        memcpy(approaches, all, sizeof(CloseApproach) * (found < maxApproaches ? found : maxApproaches));
+    }
+    for (int c = 0; c < chunks; c++)
+        free(job.lists[c].items);
+    free(job.lists);
+    free(candidates);
+    free(all);
+    return all == NULL || job.failed ? -1 : found;
+}
@@ -0,0 +1,31 @@
+#ifndef APPROACH_H
+#define APPROACH_H
+
+#include "planet.h"
+
+// A straight ship path: at start at startTime, cruising at velocity until endTime.
+typedef struct {
+    Vector3D start;      // AU
+    Vector3D velocity;   // AU/day
+    double startTime, endTime;  // days
+} ShipPath;
+
+typedef struct {
+    int body;          // index into knownDestinations
+    double time;       // days
+    double distance;   // AU
+} CloseApproach;
+
+// Finds every local minimum of the distance between the ship and a known
+// destination that comes within threshold AU during the path, ordered by
+// time. A distance still falling at endTime, or rising from startTime, counts
+// as a minimum at that end. Bodies whose orbit (the annulus between periapsis
+// and apoapsis) stays farther than threshold from the path's distance range
+// from the Sun are skipped; the rest are searched on up to threads threads
+// (<= 0: every CPU) by interval bounds and root finding on the distance's
+// derivative. Writes up to maxApproaches and returns the number found, which
+// may be larger, or -1 on bad arguments or allocation failure.
+int findCloseApproaches(const ShipPath *path, double threshold, int threads,
+                        CloseApproach *approaches, int maxApproaches);
+
+#endif
@@ -0,0 +1,342 @@
+#include "batch.h"
+#include "destinations.h"
+#include "launchwindow.h"
+#include "lambert.h"
+#include "itinerary.h"
+#include "approach.h"
+#include "propagate.h"
+#include "instrument.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH_BUFFER_SIZE (1 << 20)
+#define MAX_COMMAND_LINE 1024
+#define MAX_BATCH_WINDOWS 5
+#define MAX_BATCH_APPROACHES 32
+#define PI 3.141592653589793
+
+static CommandLimits commandLimits;  // all zero: no caps
+
+void setCommandLimits(const CommandLimits *limits) {
+    if (limits != NULL)
+        commandLimits = *limits;
+    else
+        memset(&commandLimits, 0, sizeof(commandLimits));
+}
+
+void outputInit(OutputBuffer *out, size_t capacity, FILE *sink) {
+    out->data = malloc(capacity);
+    out->length = 0;
+    out->capacity = out->data ? capacity : 0;
+    out->sink = sink;
+}
+
+void outputFree(OutputBuffer *out) {
+    outputFlush(out);
+    free(out->data);
+    out->data = NULL;
+    out->length = out->capacity = 0;
+}
+
+void outputFlush(OutputBuffer *out) {
+    if (out->sink == NULL || out->length == 0)
+        return;
+    fwrite(out->data, 1, out->length, out->sink);
+    out->length = 0;
+}
+
+// Makes room for at least needed more bytes, flushing or growing the buffer.
+static void outputReserve(OutputBuffer *out, size_t needed) {
+    if (out->length + needed <= out->capacity)
+        return;
+    outputFlush(out);
+    if (out->length + needed <= out->capacity)
+        return;
+    size_t capacity = out->capacity ? out->capacity : 4096;
+    while (capacity < out->length + needed)
+        capacity *= 2;
+    char *data = realloc(out->data, capacity);
+    if (data == NULL)
+        return;
+    out->data = data;
+    out->capacity = capacity;
+}
+
+void outputPrintf(OutputBuffer *out, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int needed = vsnprintf(out->data + out->length, out->capacity - out->length, format, args);
+    va_end(args);
+    if (needed < 0)
+        return;
+    if ((size_t)needed >= out->capacity - out->length) {
+        outputReserve(out, (size_t)needed + 1);
+        if ((size_t)needed >= out->capacity - out->length)
+            return;
+        va_start(args, format);
+        vsnprintf(out->data + out->length, out->capacity - out->length, format, args);
+        va_end(args);
+    }
+    out->length += (size_t)needed;
+}
+
+// Parses exactly count numbers from text; fails on extra or missing fields.
+static int parseNumbers(const char *text, double *values, int count) {
+    char *end;
+    for (int i = 0; i < count; i++) {
+        values[i] = strtod(text, &end);
+        if (end == text)
+            return 0;
+        text = end;
+    }
+    while (isspace((unsigned char)*text))
+        text++;
+    return *text == '\0';
+}
+
+static int countFields(const char *text) {
+    int fields = 0;
+    while (*text) {
+        while (isspace((unsigned char)*text))
+            text++;
+        if (*text == '\0')
+            break;
+        fields++;
+        while (*text && !isspace((unsigned char)*text))
+            text++;
+    }
+    return fields;
+}
+
+static int commandError(OutputBuffer *out, int lineNumber, const char *message) {
+    outputPrintf(out, "E %d %s\n", lineNumber, message);
+    return -1;
+}
+
+int executeCommand(const char *line, int lineNumber, ShipState *state, OutputBuffer *out) {
+    while (isspace((unsigned char)*line))
+        line++;
+    if (*line == '\0' || *line == '#')
+        return 0;
+
+    char command = (char)toupper((unsigned char)*line);
+    const char *args = line + 1;
+    if (*args != '\0' && !isspace((unsigned char)*args))
+        return commandError(out, lineNumber, "unknown command");
+    double v[6];
+
+    if (command == 'H') {
+        int fields = countFields(args);
+        if ((fields != 2 && fields != 4) || !parseNumbers(args, v, fields))
+            return commandError(out, lineNumber, "usage: H r1 r2 | H r r x y");
+        if (fabs(v[0] - v[1]) < 1e-6) {
+            if (fields != 4)
+                return commandError(out, lineNumber, "same orbit: target x y required");
+            Vector3D target = { v[2], v[3], 0.0 };
+            double orbitalPeriod = 365.25 * pow(v[0], 1.5);
+            outputPrintf(out, "H phasing %.10g\n", computePhasingTime(state->shipPosition, target, orbitalPeriod));
+        } else {
+            outputPrintf(out, "H hohmann %.10g\n", computeHohmannTransferTime(v[0], v[1]));
+        }
+    } else if (command == 'T') {
+        if (!parseNumbers(args, v, 4))
+            return commandError(out, lineNumber, "usage: T x y z dt");
+        Vector3D position = { v[0], v[1], v[2] };
+        travelTo(state, position, v[3]);
+        outputPrintf(out, "T %.10g %.10g %.10g %.10g %s\n", state->currentTime,
+                     state->shipPosition.x, state->shipPosition.y, state->shipPosition.z,
+                     state->currentDestination.name);
+    } else if (command == 'I') {
+        if (!parseNumbers(args, v, 0))
+            return commandError(out, lineNumber, "usage: I");
+        double distanceFromSun = sqrt(state->shipPosition.x * state->shipPosition.x +
+                                      state->shipPosition.y * state->shipPosition.y);
+        outputPrintf(out, "I %.10g %.10g %.10g %.10g %.10g %s\n", state->currentTime,
+                     state->shipPosition.x, state->shipPosition.y, state->shipPosition.z,
+                     distanceFromSun, state->currentDestination.name);
+    } else if (command == 'P') {
+        char name[64];
+        int consumed = 0;
+        if (sscanf(args, "%63s%n", name, &consumed) != 1 || !parseNumbers(args + consumed, v, 1))
+            return commandError(out, lineNumber, "usage: P body t");
+        Planet *body = getDestinationByName(name);
+        if (body == NULL)
+            return commandError(out, lineNumber, "unknown destination");
+        Vector3D position = getDestinationPosition((int)(body - knownDestinations), v[0]);
+        outputPrintf(out, "P %.10g %.10g %.10g\n", position.x, position.y, position.z);
+    } else if (command == 'A') {
+        if (!parseNumbers(args, v, 4))
+            return commandError(out, lineNumber, "usage: A x y z t");
+        ShipState probe;
+        Vector3D position = { v[0], v[1], v[2] };
+        if (determineDestination(position, v[3], &probe) != 0)
+            return commandError(out, lineNumber, "out of memory");
+        outputPrintf(out, "A %s\n", probe.currentDestination.name);
+    } else if (command == 'W') {
+        char sourceName[64], targetName[64];
+        int consumed = 0;
+        if (sscanf(args, "%63s %63s%n", sourceName, targetName, &consumed) != 2 ||
+            !parseNumbers(args + consumed, v, 6))
+            return commandError(out, lineNumber, "usage: W source target dep0 dep1 depStep tof0 tof1 tofStep");
+        Planet *source = getDestinationByName(sourceName);
+        Planet *target = getDestinationByName(targetName);
+        if (source == NULL || target == NULL)
+            return commandError(out, lineNumber, "unknown destination");
+        LaunchWindowGrid grid = { v[0], v[1], v[2], v[3], v[4], v[5], 0 };
+        if (commandLimits.maxGridCells > 0 && launchWindowGridCells(&grid) > commandLimits.maxGridCells)
+            return commandError(out, lineNumber, "search grid too large");
+        LaunchWindow windows[MAX_BATCH_WINDOWS];
+        int found = findLaunchWindows(source, target, &grid, windows, MAX_BATCH_WINDOWS);
+        if (found < 0)
+            return commandError(out, lineNumber, "invalid search grid");
+        if (found == 0)
+            outputPrintf(out, "W none\n");
+        for (int k = 0; k < found; k++) {
+            outputPrintf(out, "W %.10g %.10g %.10g %.10g %.10g\n", windows[k].departureTime,
+                         windows[k].timeOfFlight, windows[k].phaseError * 180.0 / PI,
+                         windows[k].tofError, windows[k].score);
+        }
+    } else if (command == 'L') {
+        char sourceName[64], targetName[64];
+        int consumed = 0;
+        if (sscanf(args, "%63s %63s%n", sourceName, targetName, &consumed) != 2 ||
+            !parseNumbers(args + consumed, v, 2))
+            return commandError(out, lineNumber, "usage: L source target departure tof");
+        Planet *source = getDestinationByName(sourceName);
+        Planet *target = getDestinationByName(targetName);
+        if (source == NULL || target == NULL)
+            return commandError(out, lineNumber, "unknown destination");
+        Vector3D v1, v2;
+        Vector3D r1 = getDestinationPosition((int)(source - knownDestinations), v[0]);
+        Vector3D r2 = getDestinationPosition((int)(target - knownDestinations), v[0] + v[1]);
+        if (solveLambert(r1, r2, v[1], 0, &v1, &v2) != 0)
+            return commandError(out, lineNumber, "no transfer for this time of flight");
+        outputPrintf(out, "L %.10g %.10g %.10g %.10g %.10g %.10g\n", v1.x, v1.y, v1.z, v2.x, v2.y, v2.z);
+    } else if (command == 'R') {
+        char name[64];
+        int consumed = 0, count = 0, start;
+        int targets[ITINERARY_MAX_STOPS];
+        if (sscanf(args, "%63s%n", name, &consumed) != 1)
+            return commandError(out, lineNumber, "usage: R start startTime body...");
+        Planet *body = getDestinationByName(name);
+        args += consumed;
+        if (body == NULL)
+            return commandError(out, lineNumber, "unknown destination");
+        start = (int)(body - knownDestinations);
+        if (sscanf(args, "%lf%n", &v[0], &consumed) != 1)
+            return commandError(out, lineNumber, "usage: R start startTime body...");
+        args += consumed;
+        while (sscanf(args, "%63s%n", name, &consumed) == 1) {
+            args += consumed;
+            if ((body = getDestinationByName(name)) == NULL)
+                return commandError(out, lineNumber, "unknown destination");
+            if (count == ITINERARY_MAX_STOPS || (commandLimits.maxStops > 0 && count == commandLimits.maxStops))
+                return commandError(out, lineNumber, "too many stops");
+            targets[count++] = (int)(body - knownDestinations);
+        }
+        Itinerary itinerary;
+        if (planItinerary(start, targets, count, v[0], NULL, &itinerary) != 0)
+            return commandError(out, lineNumber, "no itinerary");
+        for (int k = 0; k < itinerary.count; k++) {
+            outputPrintf(out, "R %s %.10g %.10g\n", knownDestinations[itinerary.legs[k].body].name,
+                         itinerary.legs[k].departureTime, itinerary.legs[k].arrivalTime);
+        }
+        outputPrintf(out, "R total %.10g %s\n", itinerary.arrivalTime, itinerary.optimal ? "optimal" : "best");
+    } else if (command == 'C') {
+        if (!parseNumbers(args, v, 4) || !(v[3] > 0.0))
+            return commandError(out, lineNumber, "usage: C x y z dt");
+        // The search time grows with both the path and the catalog.
+        if (commandLimits.maxApproachBodyDays > 0.0 &&
+            v[3] * knownDestinationsCount > commandLimits.maxApproachBodyDays)
+            return commandError(out, lineNumber, "path too long");
+        ShipPath path = { state->shipPosition,
+                          { (v[0] - state->shipPosition.x) / v[3], (v[1] - state->shipPosition.y) / v[3],
+                            (v[2] - state->shipPosition.z) / v[3] },
+                          state->currentTime, state->currentTime + v[3] };
+        CloseApproach approaches[MAX_BATCH_APPROACHES];
+        int found = findCloseApproaches(&path, ARRIVAL_THRESHOLD, 0, approaches, MAX_BATCH_APPROACHES);
+        if (found < 0)
+            return commandError(out, lineNumber, "approach search failed");
+        if (found == 0)
+            outputPrintf(out, "C none\n");
+        for (int k = 0; k < found && k < MAX_BATCH_APPROACHES; k++) {
+            outputPrintf(out, "C %s %.10g %.10g\n", knownDestinations[approaches[k].body].name,
+                         approaches[k].time, approaches[k].distance);
+        }
+    } else if (command == 'G') {
+        char methodName[16], forces[16];
+        int consumed = 0;
+        if (sscanf(args, "%15s %15s%n", methodName, forces, &consumed) != 2 ||
+            !parseNumbers(args + consumed, v, 5))
+            return commandError(out, lineNumber, "usage: G leapfrog|yoshida|rk45 sun|planets step dt vx vy vz");
+        PropagateMethod method;
+        if (strcmp(methodName, "leapfrog") == 0)
+            method = PROPAGATE_LEAPFROG;
+        else if (strcmp(methodName, "yoshida") == 0)
+            method = PROPAGATE_YOSHIDA;
+        else if (strcmp(methodName, "rk45") == 0)
+            method = PROPAGATE_RK45;
+        else
+            return commandError(out, lineNumber, "unknown propagation method");
+        PropagateOptions options;
+        propagateOptionsInit(&options, method, v[0]);
+        options.maxSteps = commandLimits.maxSteps;
+        long maxSteps = commandLimits.maxSteps > 0 ? commandLimits.maxSteps : PROPAGATE_MAX_STEPS;
+        Planet perturbers[PROPAGATE_MAX_PERTURBERS];
+        double perturberGM[PROPAGATE_MAX_PERTURBERS];
+        if (strcmp(forces, "planets") == 0) {
+            // Not the planet the ship is at: the flight starts once it has escaped it.
+            int found = getDestinationPerturbers(perturbers, perturberGM, PROPAGATE_MAX_PERTURBERS);
+            for (int k = 0; k < found; k++) {
+                if (strcmp(perturbers[k].name, state->currentDestination.name) != 0) {
+                    perturbers[options.perturberCount] = perturbers[k];
+                    perturberGM[options.perturberCount++] = perturberGM[k];
+                }
+            }
+            options.perturbers = perturbers;
+            options.perturberGM = perturberGM;
+        } else if (strcmp(forces, "sun") != 0) {
+            return commandError(out, lineNumber, "forces must be sun or planets");
+        }
+        ShipState probe = *state;
+        Vector3D velocity = { v[2], v[3], v[4] };
+        ShipBatch ship = { &probe.shipPosition.x, &probe.shipPosition.y, &probe.shipPosition.z,
+                           &velocity.x, &velocity.y, &velocity.z, 1 };
+        if (!(v[0] > 0.0))
+            return commandError(out, lineNumber, "step must be positive");
+        if (method != PROPAGATE_RK45 && !(ceil(fabs(v[1]) / v[0]) <= (double)maxSteps))
+            return commandError(out, lineNumber, "too many steps");
+        if (propagateShips(ship, state->currentTime, v[1], &options) != 0)
+            return commandError(out, lineNumber, "propagation failed");
+        probe.currentTime += v[1];
+        if (determineDestination(probe.shipPosition, probe.currentTime, &probe) != 0)
+            return commandError(out, lineNumber, "out of memory");
+        outputPrintf(out, "G %.10g %.10g %.10g %.10g %.10g %.10g %.10g %s\n", probe.currentTime,
+                     probe.shipPosition.x, probe.shipPosition.y, probe.shipPosition.z,
+                     velocity.x, velocity.y, velocity.z, probe.currentDestination.name);
+    } else {
+        return commandError(out, lineNumber, "unknown command");
+    }
+    return 0;
+}
+
+int runBatch(FILE *in, FILE *out, ShipState *state) {
+    OutputBuffer buffer;
+    outputInit(&buffer, BATCH_BUFFER_SIZE, out);
+    char line[MAX_COMMAND_LINE];
+    int lineNumber = 0, failures = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineNumber++;
+        INSTR_TIMER_START(command);
+        if (executeCommand(line, lineNumber, state, &buffer) != 0)
+            failures++;
+        INSTR_COMMAND_STOP(command, line[strspn(line, " \t")]);
+        INSTR_POLL();
+    }
+    outputFree(&buffer);
+    fflush(out);
+    return failures;
+}
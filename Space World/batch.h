@@ -0,0 +1,73 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "navigation.h"
+
+// Buffered writer: output collects in memory and goes to sink in large writes.
+// A NULL sink means the caller drains data itself (e.g. onto a socket).
+typedef struct {
+    char *data;
+    size_t length;
+    size_t capacity;
+    FILE *sink;
+} OutputBuffer;
+
+void outputInit(OutputBuffer *out, size_t capacity, FILE *sink);
+void outputFree(OutputBuffer *out);
+void outputPrintf(OutputBuffer *out, const char *format, ...);
+void outputFlush(OutputBuffer *out);
+
+// Caps on the work of one command; 0 leaves a quantity uncapped.
+typedef struct {
+    int maxStops;        // R: bodies to visit
+    long maxGridCells;   // W: departure by time-of-flight cells
+    long maxSteps;       // G: propagation steps (RK45: attempts)
+    double maxApproachBodyDays;  // C: path duration times catalog bodies
+} CommandLimits;
+
+// Applies limits to every later command (NULL, the default, caps nothing).
+// Commands over a limit fail with an error line.
+void setCommandLimits(const CommandLimits *limits);
+
+// Runs one fully specified command without prompting and appends one
+// result line to out. Commands:
+//   H r1 r2        Hohmann transfer time  -> "H hohmann <days>"
+//   H r r x y      same-orbit phasing     -> "H phasing <days>"
+//   T x y z dt     travel                 -> "T <time> <x> <y> <z> <destination>"
+//   I              ship information       -> "I <time> <x> <y> <z> <sun distance> <destination>"
+//   P body t       destination position   -> "P <x> <y> <z>"
+//   A x y z t      destination a ship at x y z would arrive at, without
+//                  moving the ship         -> "A <destination>"
+//   W src dst dep0 dep1 depStep tof0 tof1 tofStep
+//                  launch windows, best first, one line each (or "W none")
+//                                         -> "W <departure> <tof> <phase error deg> <tof error> <score>"
+//   L src dst departure tof
+//                  Lambert transfer between the bodies' positions (AU/day)
+//                                         -> "L <v1x> <v1y> <v1z> <v2x> <v2y> <v2z>"
+//   R start startTime body...
+//                  itinerary visiting every body as early as possible, one
+//                  line per leg then a total
+//                                         -> "R <body> <departure> <arrival>"
+//                                            "R total <arrival> optimal|best"
+//   C x y z dt     close approaches on a straight path from the ship's position
+//                  to x y z over dt days, without moving the ship; one line
+//                  per approach within the arrival threshold, in time order
+//                  (or "C none")       -> "C <body> <time> <distance>"
+//   G method forces step dt vx vy vz
+//                  ship's position and velocity after dt days of flight from
+//                  its position at velocity vx vy vz (AU/day), without moving
+//                  the ship; method is leapfrog, yoshida or rk45 (step is the
+//                  first try), forces sun or planets (the catalog's major
+//                  planets but the one the ship is at)
+//                                         -> "G <time> <x> <y> <z> <vx> <vy> <vz> <destination>"
+// Blank lines and lines starting with '#' produce no output.
+// Errors produce "E <lineNumber> <message>". Returns 0, or -1 on error.
+int executeCommand(const char *line, int lineNumber, ShipState *state, OutputBuffer *out);
+
+// Executes every command line from in, writing results to out.
+// Returns the number of commands that failed.
+int runBatch(FILE *in, FILE *out, ShipState *state);
+
+#endif
@@ -0,0 +1,388 @@
+// Microbenchmarks for the navigation and recursion hot paths.
+// Build and run with: ./build.sh bench [-j] [-r runs] [-t seconds]
+#include "planet.h"
+#include "ephemeris.h"
+#include "destinations.h"
+#include "navigation.h"
+#include "propagate.h"
+#include "lambert.h"
+#include "../Recursion/color-map.h"
+#include "../Recursion/factorial.h"
+#include "../Recursion/factorial-mod.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_RUNS 10
+#define DEFAULT_SECONDS 0.05  // minimum length of one timed run
+#define BATCH_BODIES 4096
+#define PROPAGATE_SHIPS 1024
+
+typedef void (*BenchFunction)(void *context, long iterations);
+
+typedef struct {
+    char name[64];
+    long iterations;   // per run
+    int runs;
+    double nsPerOp;    // mean over runs
+    double stddevNs;
+    double minNs;
+    double opsPerSecond;
+} BenchResult;
+
+// Results are folded into this so the compiler cannot drop the work.
+static volatile double benchSink;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double timeRun(BenchFunction function, void *context, long iterations) {
+    double start = nowSeconds();
+    function(context, iterations);
+    return nowSeconds() - start;
+}
+
+// Calibrates the iteration count so a run takes at least minSeconds, then
+// times runs runs and reports per-operation statistics.
+static BenchResult runBenchmark(const char *name, BenchFunction function, void *context,
+                                int runs, double minSeconds) {
+    long iterations = 1;
+    while (timeRun(function, context, iterations) < minSeconds && iterations < (1L << 40))
+        iterations *= 2;
+
+    BenchResult result;
+    memset(&result, 0, sizeof(result));
+    snprintf(result.name, sizeof(result.name), "%s", name);
+    result.iterations = iterations;
+    result.runs = runs;
+    result.minNs = INFINITY;
+    double sum = 0.0, sumSquares = 0.0;
+    for (int r = 0; r < runs; r++) {
+        double ns = timeRun(function, context, iterations) * 1e9 / iterations;
+        sum += ns;
+        sumSquares += ns * ns;
+        if (ns < result.minNs)
+            result.minNs = ns;
+    }
+    result.nsPerOp = sum / runs;
+    result.stddevNs = runs > 1 ? sqrt(fmax(sumSquares - sum * sum / runs, 0.0) / (runs - 1)) : 0.0;
+    result.opsPerSecond = 1e9 / result.nsPerOp;
+    return result;
+}
+
+// --- Benchmarked operations ---
+
+static void benchPlanetPosition(void *context, long iterations) {
+    Planet *planet = context;
+    double acc = 0.0;
+    for (long i = 0; i < iterations; i++)
+        acc += getPlanetPosition(*planet, 100.0 + i * 0.37).x;
+    benchSink = acc;
+}
+
+typedef struct {
+    BodySet bodies;
+    double *x, *y, *z;
+} BatchContext;
+
+// One operation is one body at one epoch, to compare with getPlanetPosition.
+static void benchPositionsBatch(void *context, long iterations) {
+    BatchContext *batch = context;
+    double acc = 0.0;
+    for (long done = 0; done < iterations; done += batch->bodies.count) {
+        double time = 100.0 + done * 0.37;
+        computePositionsBatch(batch->bodies, &time, 1, batch->x, batch->y, batch->z);
+        acc += batch->x[0];
+    }
+    benchSink = acc;
+}
+
+static void benchDistance(void *context, long iterations) {
+    (void)context;
+    Vector3D a = { 0.3, -1.2, 0.01 }, b = { 1.1, 0.4, -0.02 };
+    double acc = 0.0;
+    for (long i = 0; i < iterations; i++) {
+        a.x += 1e-9;
+        acc += calculateDistance(a, b);
+    }
+    benchSink = acc;
+}
+
+typedef struct {
+    ShipState state;
+    int newEpoch;  // advance time every call, forcing an index rebuild
+} ArrivalContext;
+
+static void benchDetermineDestination(void *context, long iterations) {
+    ArrivalContext *arrival = context;
+    Vector3D pos = { -0.149, 0.9888, 0.0 };
+    for (long i = 0; i < iterations; i++) {
+        double time = arrival->newEpoch ? 100.0 + i * 1e-3 : 100.0;
+        determineDestination(pos, time, &arrival->state);
+    }
+    benchSink = arrival->state.currentDestination.position.x;
+}
+
+static void benchHohmann(void *context, long iterations) {
+    (void)context;
+    double acc = 0.0;
+    for (long i = 0; i < iterations; i++)
+        acc += computeHohmannTransferTime(1.0, 1.523 + i * 1e-12);
+    benchSink = acc;
+}
+
+typedef struct {
+    PropagateOptions options;
+    double *x, *y, *z, *vx, *vy, *vz;
+} PropagateContext;
+
+// One operation is one ship advanced by one day (one step for the symplectic methods).
+static void benchPropagate(void *context, long iterations) {
+    PropagateContext *propagate = context;
+    ShipBatch ships = { propagate->x, propagate->y, propagate->z,
+                        propagate->vx, propagate->vy, propagate->vz, PROPAGATE_SHIPS };
+    long days = (iterations + PROPAGATE_SHIPS - 1) / PROPAGATE_SHIPS;
+    propagateShips(ships, 100.0, (double)days, &propagate->options);
+    benchSink = propagate->x[0];
+}
+
+static void benchColorMap(void *context, long iterations) {
+    (void)context;
+    int solved = 0;
+    for (long i = 0; i < iterations; i++) {
+        memset(colors, 0, sizeof(colors));
+        solved += colorMap(0);
+    }
+    benchSink = solved;
+}
+
+#define BINOMIAL_BATCH 4096
+
+typedef struct {
+    FactorialModTable table;
+    uint64_t n[BINOMIAL_BATCH], k[BINOMIAL_BATCH];
+    uint32_t out[BINOMIAL_BATCH];
+} BinomialContext;
+
+// One operation is one (n, k) query answered by binomialModBatch.
+static void benchBinomialMod(void *context, long iterations) {
+    BinomialContext *binomial = context;
+    uint64_t acc = 0;
+    for (long done = 0; done < iterations; done += BINOMIAL_BATCH) {
+        binomialModBatch(&binomial->table, binomial->n, binomial->k, binomial->out, BINOMIAL_BATCH);
+        for (int i = 0; i < BINOMIAL_BATCH; i++)
+            acc += binomial->out[i];
+    }
+    benchSink = (double)acc;
+}
+
+static void benchBigFactorial(void *context, long iterations) {
+    unsigned long n = *(unsigned long *)context;
+    BigInt result;
+    bigInit(&result);
+    size_t digits = 0;
+    for (long i = 0; i < iterations; i++) {
+        bigFactorial(n, &result);
+        digits += bigDecimalDigits(&result);
+    }
+    bigFree(&result);
+    benchSink = (double)digits;
+}
+
+// --- Catalog setup ---
+
+// Loads a random catalog of count bodies that includes Earth.
+static int loadRandomCatalog(int count) {
+    char path[] = "/tmp/space_benchXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return -1;
+    FILE *file = fdopen(fd, "w");
+    if (file == NULL) {
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    srand(12345);
+    fprintf(file, "Earth 1.0 365.25\n");
+    for (int i = 1; i < count; i++) {
+        double radius = 0.3 + 40.0 * rand() / RAND_MAX;
+        fprintf(file, "Body-%d %.6f %.4f\n", i, radius, 365.25 * pow(radius, 1.5));
+    }
+    if (fclose(file) != 0) {
+        unlink(path);
+        return -1;
+    }
+    int loaded = loadDestinations(path);
+    unlink(path);
+    return loaded;
+}
+
+// --- Reporting ---
+
+static void printTable(const BenchResult *results, int count) {
+    printf("%-40s %12s %12s %12s %14s\n", "benchmark", "ns/op", "stddev", "min", "ops/s");
+    for (int i = 0; i < count; i++) {
+        printf("%-40s %12.2f %12.2f %12.2f %14.0f\n", results[i].name, results[i].nsPerOp,
+               results[i].stddevNs, results[i].minNs, results[i].opsPerSecond);
+    }
+}
+
+static void printJson(const BenchResult *results, int count) {
+    printf("{\n  \"benchmarks\": [\n");
+    for (int i = 0; i < count; i++) {
+        printf("    {\"name\": \"%s\", \"iterations\": %ld, \"runs\": %d, \"ns_per_op\": %.4f, "
+               "\"stddev_ns\": %.4f, \"min_ns\": %.4f, \"ops_per_second\": %.2f}%s\n",
+               results[i].name, results[i].iterations, results[i].runs, results[i].nsPerOp,
+               results[i].stddevNs, results[i].minNs, results[i].opsPerSecond, i + 1 < count ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+int main(int argc, char *argv[]) {
+    int runs = DEFAULT_RUNS, json = 0;
+    double seconds = DEFAULT_SECONDS;
+    int option;
+    while ((option = getopt(argc, argv, "jr:t:")) != -1) {
+        if (option == 'j') {
+            json = 1;
+        } else if (option == 'r') {
+            runs = atoi(optarg);
+        } else if (option == 't') {
+            seconds = atof(optarg);
+        } else {
+            fprintf(stderr, "Usage: %s [-j] [-r runs] [-t seconds per run]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+
+    BenchResult results[32];
+    int count = 0;
+
+    Planet mars = { "Mars", 1.523, 687.0 };
+    results[count++] = runBenchmark("getPlanetPosition", benchPlanetPosition, &mars, runs, seconds);
+
+    BatchContext batch;
+    memset(&batch, 0, sizeof(batch));
+    double *radius = malloc(sizeof(double) * BATCH_BODIES);
+    double *period = malloc(sizeof(double) * BATCH_BODIES);
+    for (int i = 0; i < BATCH_BODIES; i++) {
+        radius[i] = 0.3 + 0.01 * i;
+        period[i] = 365.25 * pow(radius[i], 1.5);
+    }
+    batch.bodies.orbitRadius = radius;
+    batch.bodies.orbitalPeriod = period;
+    batch.bodies.count = BATCH_BODIES;
+    batch.x = malloc(sizeof(double) * BATCH_BODIES);
+    batch.y = malloc(sizeof(double) * BATCH_BODIES);
+    batch.z = malloc(sizeof(double) * BATCH_BODIES);
+    results[count++] = runBenchmark("computePositionsBatch (per body)", benchPositionsBatch, &batch, runs, seconds);
+
+    // The same bodies on inclined, eccentric orbits.
+    BatchContext keplerBatch = batch;
+    KeplerSet orbits;
+    keplerSetInit(&orbits);
+    for (int i = 0; i < BATCH_BODIES; i++) {
+        OrbitalElements elements = { radius[i], period[i], (i % 95) / 100.0, 0.1, 0.01 * i, 0.02 * i, 0.03 * i };
+        if (keplerSetAdd(&orbits, &elements) < 0) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+    }
+    keplerBatch.bodies.orbits = keplerSetOrbits(&orbits);
+    results[count++] = runBenchmark("computePositionsBatch Kepler (per body)", benchPositionsBatch, &keplerBatch, runs, seconds);
+    keplerSetFree(&orbits);
+
+    results[count++] = runBenchmark("calculateDistance", benchDistance, NULL, runs, seconds);
+
+    static const int catalogSizes[] = { 8, 1000, 100000 };
+    for (size_t s = 0; s < sizeof(catalogSizes) / sizeof(catalogSizes[0]); s++) {
+        if (loadRandomCatalog(catalogSizes[s]) < 0) {
+            fprintf(stderr, "could not create a catalog of %d bodies\n", catalogSizes[s]);
+            return 1;
+        }
+        ArrivalContext arrival;
+        memset(&arrival, 0, sizeof(arrival));
+        char name[64];
+        for (arrival.newEpoch = 0; arrival.newEpoch <= 1; arrival.newEpoch++) {
+            snprintf(name, sizeof(name), "determineDestination n=%d %s", catalogSizes[s],
+                     arrival.newEpoch ? "new epoch" : "same epoch");
+            results[count++] = runBenchmark(name, benchDetermineDestination, &arrival, runs, seconds);
+        }
+    }
+
+    results[count++] = runBenchmark("computeHohmannTransferTime", benchHohmann, NULL, runs, seconds);
+
+    // Ships on mildly eccentric, inclined orbits between 0.8 and 3 AU.
+    PropagateContext propagate;
+    double *shipState = malloc(sizeof(double) * PROPAGATE_SHIPS * 6);
+    double *columns[6];
+    for (int c = 0; c < 6; c++)
+        columns[c] = shipState + (size_t)c * PROPAGATE_SHIPS;
+    propagate.x = columns[0];
+    propagate.y = columns[1];
+    propagate.z = columns[2];
+    propagate.vx = columns[3];
+    propagate.vy = columns[4];
+    propagate.vz = columns[5];
+    static const char *propagateNames[] = { "leapfrog", "yoshida", "rk45" };
+    for (int m = PROPAGATE_LEAPFROG; m <= PROPAGATE_RK45; m++) {
+        for (int i = 0; i < PROPAGATE_SHIPS; i++) {
+            double r = 0.8 + 2.2 * i / PROPAGATE_SHIPS;
+            double speed = sqrt(SUN_GM / r) * (1.0 + 0.1 * (i % 5) / 5.0);
+            propagate.x[i] = r;
+            propagate.y[i] = propagate.z[i] = propagate.vx[i] = 0.0;
+            propagate.vy[i] = speed;
+            propagate.vz[i] = 0.05 * speed;
+        }
+        propagateOptionsInit(&propagate.options, (PropagateMethod)m, 1.0);
+        char name[64];
+        snprintf(name, sizeof(name), "propagateShips %s (per ship-day)", propagateNames[m]);
+        results[count++] = runBenchmark(name, benchPropagate, &propagate, runs, seconds);
+    }
+    free(shipState);
+
+    initMap();
+    results[count++] = runBenchmark("colorMap 13 regions", benchColorMap, NULL, runs, seconds);
+    static BinomialContext binomial;
+    if (factorialModInit(&binomial.table, 1000003, 0) != 0)
+        return 1;
+    srand(777);
+    static const uint64_t binomialRanges[] = { 1000000, 1000000000000ULL };
+    for (size_t r = 0; r < sizeof(binomialRanges) / sizeof(binomialRanges[0]); r++) {
+        for (int i = 0; i < BINOMIAL_BATCH; i++) {
+            binomial.n[i] = (((uint64_t)rand() << 31) ^ (uint64_t)rand()) % binomialRanges[r];
+            binomial.k[i] = binomial.n[i] ? (((uint64_t)rand() << 31) ^ (uint64_t)rand()) % binomial.n[i] : 0;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "binomialModBatch n<%llu", (unsigned long long)binomialRanges[r]);
+        results[count++] = runBenchmark(name, benchBinomialMod, &binomial, runs, seconds);
+    }
+    factorialModFree(&binomial.table);
+    static unsigned long bigFactorialSizes[] = { 10000, 100000 };
+    for (size_t s = 0; s < sizeof(bigFactorialSizes) / sizeof(bigFactorialSizes[0]); s++) {
+        char name[64];
+        snprintf(name, sizeof(name), "bigFactorial(%lu)", bigFactorialSizes[s]);
+        results[count++] = runBenchmark(name, benchBigFactorial, &bigFactorialSizes[s], runs, seconds);
+    }
+
+    if (json)
+        printJson(results, count);
+    else
+        printTable(results, count);
+
+    free(radius);
+    free(period);
+    free(batch.x);
+    free(batch.y);
+    free(batch.z);
+    return 0;
+}
@@ -1,7 +1,73 @@
 #!/bin/bash
-clang -c planet.c -o planet.o
-clang -c destinations.c -o destinations.o
-clang -c navigation.c -o navigation.o
-clang -c main.c -o main.o
-clang planet.o destinations.o navigation.o main.o -o space_navigator
+# Usage: ./build.sh            build and run space_navigator
+#        ./build.sh bench ...  build and run the space_bench microbenchmarks
+#        ./build.sh export ... build and run the space_export table exporter
+#        ./build.sh loadgen ... build and run the space_loadgen daemon load generator
+# Set INSTRUMENT=1 to compile in the hot-path counters and latency histograms.
+# -O2 lets the compiler vectorize the batch ephemeris kernel, at SSE2 width by
+# default. Set NATIVE=1 to target this machine's vector units (AVX2, AVX-512)
+# with -march=native; the binaries then may not run on older CPUs.
+CFLAGS="-O2"
+[ "$NATIVE" = "1" ] && CFLAGS="$CFLAGS -march=native"
+[ "$INSTRUMENT" = "1" ] && CFLAGS="$CFLAGS -DSPACENAV_INSTRUMENT"
+# libspacenav: the navigation core, free of I/O and global state (spacenav.h,
+# propagate.h, lambert.h). It has no instrumentation, so it links without
+# instrument.o.
+clang $CFLAGS -c planet.c -o planet.o
+clang $CFLAGS -c ephemeris.c -o ephemeris.o
+clang $CFLAGS -c kepler.c -o kepler.o
+clang $CFLAGS -c chebyshev.c -o chebyshev.o
+clang $CFLAGS -c lambert.c -o lambert.o
+clang $CFLAGS -c propagate.c -o propagate.o
+clang $CFLAGS -c spatial.c -o spatial.o
+clang $CFLAGS -c spacenav.c -o spacenav.o
+rm -f libspacenav.a
+ar rcs libspacenav.a planet.o ephemeris.o kepler.o chebyshev.o lambert.o propagate.o spatial.o spacenav.o
+
+# The console and tools, linked against the library.
+clang $CFLAGS -c ephemfile.c -o ephemfile.o
+clang $CFLAGS -c destinations.c -o destinations.o
+clang $CFLAGS -c navigation.c -o navigation.o
+clang $CFLAGS -c batch.c -o batch.o
+clang $CFLAGS -c parallel.c -o parallel.o
+clang $CFLAGS -c launchwindow.c -o launchwindow.o
+clang $CFLAGS -c fleet.c -o fleet.o
+clang $CFLAGS -c instrument.c -o instrument.o
+clang $CFLAGS -c itinerary.c -o itinerary.o
+clang $CFLAGS -c approach.c -o approach.o
+clang $CFLAGS -c journal.c -o journal.o
+clang $CFLAGS -c server.c -o server.o
+OBJECTS="ephemfile.o destinations.o navigation.o batch.o parallel.o launchwindow.o fleet.o instrument.o itinerary.o approach.o journal.o server.o"
+
+if [ "$1" = "bench" ]; then
+  clang $CFLAGS -c benchmark.c -o benchmark.o
+  clang $CFLAGS -DCOLOR_MAP_NO_MAIN -c ../Recursion/color-map.c -o color-map.o
+  clang $CFLAGS -c ../Recursion/graph.c -o graph.o
+  clang $CFLAGS -DDSATUR_NO_MAIN -c ../Recursion/dsatur.c -o dsatur.o
+  clang $CFLAGS -DFACTORIAL_NO_MAIN -c ../Recursion/factorial.c -o factorial.o
+  clang $CFLAGS -c ../Recursion/bigint.c -o bigint.o
+  clang $CFLAGS -DFACTORIAL_MOD_NO_MAIN -c ../Recursion/factorial-mod.c -o factorial-mod.o
+  clang $OBJECTS benchmark.o color-map.o graph.o dsatur.o factorial.o bigint.o factorial-mod.o libspacenav.a -lm -pthread -o space_bench
+  shift
+  ./space_bench "$@"
+  exit
+fi
+
+if [ "$1" = "export" ]; then
+  clang $CFLAGS -c export.c -o export.o
+  clang $OBJECTS export.o libspacenav.a -lm -pthread -o space_export
+  shift
+  ./space_export "$@"
+  exit
+fi
+
+if [ "$1" = "loadgen" ]; then
+  clang $CFLAGS loadgen.c -o space_loadgen
+  shift
+  ./space_loadgen "$@"
+  exit
+fi
+
+clang $CFLAGS -c main.c -o main.o
+clang $OBJECTS main.o libspacenav.a -lm -pthread -o space_navigator
 ./space_navigator
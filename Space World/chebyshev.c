@@ -0,0 +1,251 @@
+#include "chebyshev.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI 3.141592653589793
+#define MAX_DEGREE 32
+
+void ephemerisCacheFree(EphemerisCache *cache) {
+    free(cache->orbitRadius);
+    free(cache->orbitalPeriod);
+    free(cache->segmentLength);
+    free(cache->segmentCount);
+    free(cache->coeffOffset);
+    free(cache->coeffs);
+    free(cache->orbitData);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Longest segment for which a degree-n fit of a circular orbit stays within
+// tolerance, from the Chebyshev truncation bound R * (w*h)^(n+1) / (2^n (n+1)!)
+// where w is the angular rate and h the half-length of the segment.
+static double segmentLengthFor(double radius, double period, int degree, double tolerance) {
+    double bound = tolerance / radius;
+    for (int k = 1; k <= degree + 1; k++)
+        bound *= (k <= degree ? 2.0 : 1.0) * k;
+    double halfLength = pow(bound, 1.0 / (degree + 1)) * period / (2 * PI);
+    return 2.0 * halfLength;
+}
+
+// Fits one segment: samples the orbit at the Chebyshev nodes and projects.
+static void fitSegment(BodySet body, double t0, double length, int degree, double *out) {
+    int n = degree + 1;
+    double times[MAX_DEGREE + 1], x[MAX_DEGREE + 1], y[MAX_DEGREE + 1], z[MAX_DEGREE + 1];
+    for (int k = 0; k < n; k++) {
+        double node = cos(PI * (k + 0.5) / n);
+        times[k] = t0 + 0.5 * length * (node + 1.0);
+    }
+    computePositionsBatch(body, times, n, x, y, z);
+
+    const double *samples[3] = { x, y, z };
+    for (int axis = 0; axis < 3; axis++) {
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int k = 0; k < n; k++)
+                sum += samples[axis][k] * cos(PI * j * (k + 0.5) / n);
+            out[axis * n + j] = (j == 0 ? 1.0 : 2.0) * sum / n;
+        }
+    }
+}
+
+// Sum of c[j] T_j(u) for j < n, by Clenshaw's recurrence.
+static double chebyshevSum(const double *c, int n, double u) {
+    double b1 = 0.0, b2 = 0.0;
+    for (int j = n - 1; j >= 1; j--) {
+        double b0 = 2.0 * u * b1 - b2 + c[j];
+        b2 = b1;
+        b1 = b0;
+    }
+    return u * b1 - b2 + c[0];
+}
+
+// Largest error of one degree-n fit, checked at the extrema of T_2n.
+static double segmentFitError(BodySet body, double t0, double length, int degree) {
+    int n = degree + 1;
+    double coeffs[3 * (MAX_DEGREE + 1)];
+    double times[2 * MAX_DEGREE + 3], x[2 * MAX_DEGREE + 3], y[2 * MAX_DEGREE + 3], z[2 * MAX_DEGREE + 3];
+    fitSegment(body, t0, length, degree, coeffs);
+    for (int k = 0; k <= 2 * n; k++)
+        times[k] = t0 + 0.5 * length * (cos(PI * k / (2 * n)) + 1.0);
+    computePositionsBatch(body, times, 2 * n + 1, x, y, z);
+    double worst = 0.0;
+    for (int k = 0; k <= 2 * n; k++) {
+        double u = cos(PI * k / (2 * n));
+        double dx = chebyshevSum(coeffs, n, u) - x[k];
+        double dy = chebyshevSum(coeffs + n, n, u) - y[k];
+        double dz = chebyshevSum(coeffs + 2 * n, n, u) - z[k];
+        worst = fmax(worst, sqrt(dx * dx + dy * dy + dz * dz));
+    }
+    return worst;
+}
+
+// Largest error of degree-n fits of a Keplerian body over segments of the
+// given length: every segment over one orbit (or the span if shorter), plus
+// segments that catch periapsis, the hardest part, at eight offsets, since
+// later orbits put it anywhere in a segment.
+static double measureFitError(BodySet body, double startTime, double span, double length, int degree) {
+    double period = body.orbitalPeriod[0];
+    double covered = fmin(span, period + length);
+    double worst = 0.0;
+    for (double t0 = startTime; t0 < startTime + covered; t0 += length)
+        worst = fmax(worst, segmentFitError(body, t0, length, degree));
+    double turns = -(body.orbits.meanAnomaly[0] + startTime / period);
+    double periapsis = startTime + (turns - floor(turns)) * period;
+    for (int k = 0; k <= 8; k++)
+        worst = fmax(worst, segmentFitError(body, periapsis - length * k / 8.0, length, degree));
+    return worst;
+}
+
+int ephemerisCacheBuild(EphemerisCache *cache, BodySet bodies, double startTime,
+                        double endTime, int degree, double tolerance) {
+    memset(cache, 0, sizeof(*cache));
+    if (!(endTime > startTime) || degree < 1 || degree > MAX_DEGREE || !(tolerance > 0.0))
+        return -1;
+
+    int n = degree + 1;
+    double span = endTime - startTime;
+    cache->startTime = startTime;
+    cache->endTime = endTime;
+    cache->degree = degree;
+    cache->bodyCount = bodies.count;
+    cache->orbitRadius = malloc(sizeof(double) * (bodies.count + 1));
+    cache->orbitalPeriod = malloc(sizeof(double) * (bodies.count + 1));
+    cache->segmentLength = malloc(sizeof(double) * (bodies.count + 1));
+    cache->segmentCount = malloc(sizeof(int) * (bodies.count + 1));
+    cache->coeffOffset = malloc(sizeof(long) * (bodies.count + 1));
+    if (!cache->orbitRadius || !cache->orbitalPeriod || !cache->segmentLength ||
+        !cache->segmentCount || !cache->coeffOffset) {
+        ephemerisCacheFree(cache);
+        return -1;
+    }
+    if (bodies.orbits.eccentricity != NULL) {
+        // Copy the precomputed orbits too, so the fallback outlives the catalog.
+        size_t count = (size_t)bodies.count;
+        const double *columns[8] = { bodies.orbits.eccentricity, bodies.orbits.meanAnomaly,
+                                     bodies.orbits.px, bodies.orbits.py, bodies.orbits.pz,
+                                     bodies.orbits.qx, bodies.orbits.qy, bodies.orbits.qz };
+        double *data = cache->orbitData = malloc(sizeof(double) * (8 * count + 1));
+        if (data == NULL) {
+            ephemerisCacheFree(cache);
+            return -1;
+        }
+        for (int c = 0; c < 8; c++)
+            memcpy(data + c * count, columns[c], sizeof(double) * count);
+        KeplerOrbits orbits = { data, data + count, data + 2 * count, data + 3 * count, data + 4 * count,
+                                data + 5 * count, data + 6 * count, data + 7 * count };
+        cache->orbits = orbits;
+    }
+
+    // Lay out the bodies first so the coefficients go in one allocation.
+    long total = 0;
+    for (int b = 0; b < bodies.count; b++) {
+        double radius = bodies.orbitRadius[b], period = bodies.orbitalPeriod[b];
+        double length = radius > 0.0 ? segmentLengthFor(radius, period, degree, tolerance) : span;
+        if (bodies.orbits.eccentricity != NULL && radius > 0.0) {
+            // The circular bound does not hold for ellipses, which turn fastest
+            // at periapsis: start from that rate and shrink until fits pass.
+            double e = bodies.orbits.eccentricity[b];
+            length = segmentLengthFor(radius, period * pow(1.0 - e, 1.5) / sqrt(1.0 + e), degree, tolerance);
+            BodySet body = bodySetSlice(bodies, b, 1);
+            length = span / ceil(span / length);
+            while (length > span * 1e-8 && measureFitError(body, startTime, span, length, degree) > tolerance)
+                length = span / ceil(span / (0.8 * length));
+        }
+        double segments = ceil(span / length);
+        if (segments > 1e8) {
+            ephemerisCacheFree(cache);
+            return -1;
+        }
+        cache->orbitRadius[b] = radius;
+        cache->orbitalPeriod[b] = period;
+        cache->segmentCount[b] = segments < 1.0 ? 1 : (int)segments;
+        cache->segmentLength[b] = span / cache->segmentCount[b];
+        cache->coeffOffset[b] = total;
+        total += (long)cache->segmentCount[b] * 3 * n;
+    }
+    cache->coeffCount = total;
+    cache->coeffs = malloc(sizeof(double) * (total + 1));
+    if (!cache->coeffs) {
+        ephemerisCacheFree(cache);
+        return -1;
+    }
+
+    for (int b = 0; b < bodies.count; b++) {
+        BodySet body = bodySetSlice(bodies, b, 1);
+        double *out = cache->coeffs + cache->coeffOffset[b];
+        for (int s = 0; s < cache->segmentCount[b]; s++) {
+            fitSegment(body, startTime + s * cache->segmentLength[b], cache->segmentLength[b],
+                       degree, out + (long)s * 3 * n);
+        }
+    }
+    return 0;
+}
+
+long ephemerisCacheBytes(const EphemerisCache *cache) {
+    return cache->coeffCount * (long)sizeof(double)
+         + cache->bodyCount * (long)(3 * sizeof(double) + sizeof(int) + sizeof(long));
+}
+
+// Analytic orbit, used outside the cached span.
+static Vector3D analyticPosition(const EphemerisCache *cache, int body, double time, Vector3D *velocity) {
+    if (cache->orbits.eccentricity != NULL)
+        return keplerOrbitPosition(cache->orbits, body, cache->orbitalPeriod[body], time, velocity);
+    Planet planet = { "", cache->orbitRadius[body], cache->orbitalPeriod[body] };
+    Vector3D pos = getPlanetPosition(planet, time);
+    if (velocity != NULL) {
+        double rate = 2 * PI / planet.orbitalPeriod;
+        velocity->x = -rate * pos.y;
+        velocity->y = rate * pos.x;
+        velocity->z = 0.0;
+    }
+    return pos;
+}
+
+Vector3D ephemerisCachePosition(const EphemerisCache *cache, int body, double time, Vector3D *velocity) {
+    if (!(time >= cache->startTime && time <= cache->endTime))
+        return analyticPosition(cache, body, time, velocity);
+
+    int n = cache->degree + 1;
+    double length = cache->segmentLength[body];
+    int s = (int)((time - cache->startTime) / length);
+    if (s >= cache->segmentCount[body])
+        s = cache->segmentCount[body] - 1;
+    const double *c = cache->coeffs + cache->coeffOffset[body] + (long)s * 3 * n;
+    double u = 2.0 * (time - cache->startTime - s * length) / length - 1.0;
+
+    // T_j(u) for the position and j * U_(j-1)(u) for its derivative.
+    double p[3] = { c[0], c[n], c[2 * n] };
+    double d[3] = { 0.0, 0.0, 0.0 };
+    double tPrev = 1.0, tCur = u, uPrev = 0.0, uCur = 1.0;
+    for (int j = 1; j < n; j++) {
+        for (int axis = 0; axis < 3; axis++) {
+            p[axis] += c[axis * n + j] * tCur;
+            d[axis] += c[axis * n + j] * j * uCur;
+        }
+        double tNext = 2.0 * u * tCur - tPrev;
+        double uNext = 2.0 * u * uCur - uPrev;
+        tPrev = tCur;
+        tCur = tNext;
+        uPrev = uCur;
+        uCur = uNext;
+    }
+
+    if (velocity != NULL) {
+        double scale = 2.0 / length;  // d(u)/d(time)
+        velocity->x = d[0] * scale;
+        velocity->y = d[1] * scale;
+        velocity->z = d[2] * scale;
+    }
+    Vector3D pos = { p[0], p[1], p[2] };
+    return pos;
+}
+
+void ephemerisCachePositions(const EphemerisCache *cache, double time, double *x, double *y, double *z) {
+    for (int b = 0; b < cache->bodyCount; b++) {
+        Vector3D pos = ephemerisCachePosition(cache, b, time, NULL);
+        x[b] = pos.x;
+        y[b] = pos.y;
+        z[b] = pos.z;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef CHEBYSHEV_H
+#define CHEBYSHEV_H
+
+#include "planet.h"
+#include "ephemeris.h"
+
+// Piecewise Chebyshev ephemeris cache (JPL DE style).
+// Each body's span is split into equal segments; each segment stores
+// degree + 1 coefficients per coordinate. Segment length is chosen per body
+// so the interpolation error stays below the requested tolerance, so a
+// tighter tolerance or lower degree costs memory, not accuracy.
+typedef struct {
+    double startTime, endTime; // cached span, in days
+    int degree;                // polynomial degree
+    int bodyCount;
+    double *orbitRadius;       // copies of the bodies, for the analytic fallback
+    double *orbitalPeriod;
+    KeplerOrbits orbits;       // their Keplerian orbits (eccentricity NULL: circles)
+    double *orbitData;         // storage behind orbits, if the cache owns it
+    double *segmentLength;     // per body, in days
+    int *segmentCount;         // per body
+    long *coeffOffset;         // per body, index of its first coefficient
+    double *coeffs;            // [segment][x, y, z][degree + 1], bodies back to back
+    long coeffCount;
+} EphemerisCache;
+
+// Fits every body over [startTime, endTime] to within tolerance AU.
+// Returns 0 on success, -1 on bad arguments or allocation failure.
+int ephemerisCacheBuild(EphemerisCache *cache, BodySet bodies, double startTime,
+                        double endTime, int degree, double tolerance);
+void ephemerisCacheFree(EphemerisCache *cache);
+
+// Memory used by the coefficient tables, in bytes.
+long ephemerisCacheBytes(const EphemerisCache *cache);
+
+// Position (AU) and, if velocity is not NULL, velocity (AU/day) of one body.
+// Falls back to the analytic orbit outside the cached span.
+Vector3D ephemerisCachePosition(const EphemerisCache *cache, int body, double time, Vector3D *velocity);
+
+// Positions of every cached body at one time, into SoA arrays.
+void ephemerisCachePositions(const EphemerisCache *cache, double time, double *x, double *y, double *z);
+
+#endif
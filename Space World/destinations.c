@@ -1,9 +1,15 @@
 #include "destinations.h"
+#include "lambert.h"
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-// Define the known destinations.
-Planet knownDestinations[] = {
+#define PI 3.141592653589793
+#define CATALOG_NUMBERS 7  // radius, period and five orbital elements
+
+// Define the built-in destinations, used when no catalog file is loaded.
+static Planet builtinDestinations[] = {
     { "Mercury", 0.387, 87.97 },
     { "Venus",   0.723, 224.70 },
     { "Earth",   1.0,   365.25 },
@@ -14,7 +20,313 @@ Planet knownDestinations[] = {
     { "Neptune", 30.068, 60190 }
 };
 
-int knownDestinationsCount = sizeof(knownDestinations) / sizeof(knownDestinations[0]);
+Planet *knownDestinations = builtinDestinations;
+int knownDestinationsCount = sizeof(builtinDestinations) / sizeof(builtinDestinations[0]);
+
+// Structure-of-arrays copies of the catalog and the open-addressing name index.
+// Both are (re)built lazily whenever the catalog changes, unless they were
+// handed over by useDestinationCatalog.
+static const double *destinationRadii = NULL;
+static const double *destinationPeriods = NULL;
+static const int *nameIndex = NULL; // slot -> destination index, -1 if empty
+static unsigned nameIndexMask = 0;  // capacity - 1 (capacity is a power of two)
+static int catalogReady = 0;
+static int catalogBorrowed = 0;     // storage belongs to someone else
+static unsigned catalogGeneration = 0;
+static double *ownedRadii = NULL;
+static double *ownedPeriods = NULL;
+static int *ownedNameIndex = NULL;
+// Orbital elements of a loaded catalog with any elliptical or inclined
+// orbit (NULL otherwise), and the precomputed orbits built from them.
+static OrbitalElements *catalogElements = NULL;
+static KeplerSet catalogOrbits;
+
+// FNV-1a hash of a destination name.
+static unsigned hashName(const char *name) {
+    unsigned h = 2166136261u;
+    while (*name) {
+        h ^= (unsigned char)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Returns 0, or -1 if memory runs out (the catalog then stays unbuilt).
+static int buildCatalog(void) {
+    free(ownedRadii);
+    free(ownedPeriods);
+    free(ownedNameIndex);
+    ownedRadii = malloc(sizeof(double) * (knownDestinationsCount + 1));
+    ownedPeriods = malloc(sizeof(double) * (knownDestinationsCount + 1));
+
+    // Keep the table at most half full so probe sequences stay short.
+    unsigned capacity = 16;
+    while (capacity < 2u * (unsigned)knownDestinationsCount)
+        capacity *= 2;
+    ownedNameIndex = malloc(sizeof(int) * capacity);
+    if (ownedRadii == NULL || ownedPeriods == NULL || ownedNameIndex == NULL) {
+        free(ownedRadii);
+        free(ownedPeriods);
+        free(ownedNameIndex);
+        ownedRadii = ownedPeriods = NULL;
+        ownedNameIndex = NULL;
+        return -1;
+    }
+    memset(ownedNameIndex, -1, sizeof(int) * capacity);
+    nameIndexMask = capacity - 1;
+
+    for (int i = 0; i < knownDestinationsCount; i++) {
+        ownedRadii[i] = knownDestinations[i].orbitRadius;
+        ownedPeriods[i] = knownDestinations[i].orbitalPeriod;
+
+        // Linear probing; on duplicate names the first entry wins, as with a scan.
+        unsigned slot = hashName(knownDestinations[i].name) & nameIndexMask;
+        while (ownedNameIndex[slot] != -1 &&
+               strcmp(knownDestinations[ownedNameIndex[slot]].name, knownDestinations[i].name) != 0)
+            slot = (slot + 1) & nameIndexMask;
+        if (ownedNameIndex[slot] == -1)
+            ownedNameIndex[slot] = i;
+    }
+    destinationRadii = ownedRadii;
+    destinationPeriods = ownedPeriods;
+    nameIndex = ownedNameIndex;
+    catalogReady = 1;
+    return 0;
+}
+
+// Builds the catalog's arrays and index on first use. The lookups that need
+// them have no way to report failure, so running out of memory here ends
+// the program.
+static void ensureCatalog(void) {
+    if (!catalogReady && buildCatalog() != 0) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+}
+
+// Precomputes the orbits of catalogElements, if any.
+// Returns 0, or -1 on allocation failure.
+static int buildCatalogOrbits(int count) {
+    keplerSetFree(&catalogOrbits);
+    for (int i = 0; catalogElements != NULL && i < count; i++) {
+        if (keplerSetAdd(&catalogOrbits, &catalogElements[i]) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+// Drops the current catalog storage before it is replaced.
+static void releaseCatalog(void) {
+    catalogGeneration++;
+    if (!catalogBorrowed && knownDestinations != builtinDestinations)
+        free(knownDestinations);
+    free(catalogElements);
+    catalogElements = NULL;
+    keplerSetFree(&catalogOrbits);
+    catalogBorrowed = 0;
+    catalogReady = 0;
+}
+
+// Falls back to the built-in planets after a failed load.
+static void useBuiltinCatalog(void) {
+    releaseCatalog();
+    knownDestinations = builtinDestinations;
+    knownDestinationsCount = sizeof(builtinDestinations) / sizeof(builtinDestinations[0]);
+}
+
+// Parses "<name> <radius> <period> [<e> <i> <node> <periapsis> <mean anomaly>]";
+// the name may contain spaces and the angles are in degrees. Sets *elliptical
+// when the orbital elements are present.
+// Returns 1 on success, 0 for a blank or comment line, -1 if malformed.
+static int parseCatalogLine(char *line, Planet *planet, OrbitalElements *elements, int *elliptical) {
+    char *comment = strchr(line, '#');
+    if (comment)
+        *comment = '\0';
+
+    // Find up to the last seven tokens that are numbers; everything before
+    // the numbers used is the name.
+    char *end = line + strlen(line);
+    char *fields[CATALOG_NUMBERS];
+    double values[CATALOG_NUMBERS];
+    int numbers = 0;
+    while (numbers < CATALOG_NUMBERS) {
+        while (end > line && isspace((unsigned char)end[-1]))
+            end--;
+        if (numbers == 0)
+            *end = '\0';
+        char *start = end;
+        while (start > line && !isspace((unsigned char)start[-1]))
+            start--;
+        char *numberEnd;
+        if (start == end)
+            break;
+        double value = strtod(start, &numberEnd);
+        if (numberEnd != end)
+            break;
+        numbers++;
+        fields[CATALOG_NUMBERS - numbers] = start;
+        values[CATALOG_NUMBERS - numbers] = value;
+        end = start;
+    }
+    if (numbers == 0 && end == line)
+        return 0;
+
+    // Seven numbers only count as elements if a name is left before them.
+    while (end > line && isspace((unsigned char)end[-1]))
+        end--;
+    int used = numbers == CATALOG_NUMBERS && end > line ? CATALOG_NUMBERS : 2;
+    if (numbers < used)
+        return -1;
+    char *nameEnd = fields[CATALOG_NUMBERS - used];
+    while (nameEnd > line && isspace((unsigned char)nameEnd[-1]))
+        nameEnd--;
+    *nameEnd = '\0';
+    while (isspace((unsigned char)*line))
+        line++;
+    if (*line == '\0')
+        return -1;
+
+    const double *v = values + CATALOG_NUMBERS - used;
+    planet->orbitRadius = v[0];
+    planet->orbitalPeriod = v[1];
+    if (planet->orbitalPeriod <= 0.0)
+        return -1;
+    strncpy(planet->name, line, sizeof(planet->name) - 1);
+    planet->name[sizeof(planet->name) - 1] = '\0';
+
+    memset(elements, 0, sizeof(*elements));
+    elements->semiMajorAxis = v[0];
+    elements->period = v[1];
+    *elliptical = used == CATALOG_NUMBERS;
+    if (*elliptical) {
+        if (!(v[2] >= 0.0 && v[2] < 1.0))
+            return -1;
+        elements->eccentricity = v[2];
+        elements->inclination = v[3] * PI / 180.0;
+        elements->ascendingNode = v[4] * PI / 180.0;
+        elements->argumentOfPeriapsis = v[5] * PI / 180.0;
+        elements->meanAnomaly = v[6] * PI / 180.0;
+    }
+    return 1;
+}
+
+int loadDestinations(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    int count = 0, capacity = 1024, anyElliptical = 0;
+    Planet *planets = malloc(sizeof(Planet) * capacity);
+    OrbitalElements *elements = malloc(sizeof(OrbitalElements) * capacity);
+    char line[256];
+    int lineNumber = 0, failed = planets == NULL || elements == NULL;
+    while (!failed && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        if (count == capacity) {
+            capacity *= 2;
+            Planet *morePlanets = realloc(planets, sizeof(Planet) * capacity);
+            if (morePlanets != NULL)
+                planets = morePlanets;
+            OrbitalElements *moreElements = realloc(elements, sizeof(OrbitalElements) * capacity);
+            if (moreElements != NULL)
+                elements = moreElements;
+            if (morePlanets == NULL || moreElements == NULL) {
+                failed = 1;
+                break;
+            }
+        }
+        int elliptical = 0;
+        int parsed = parseCatalogLine(line, &planets[count], &elements[count], &elliptical);
+        if (parsed == 0)
+            continue;
+        if (parsed < 0) {
+            fprintf(stderr, "%s:%d: malformed catalog line\n", path, lineNumber);
+            free(planets);
+            free(elements);
+            fclose(file);
+            return -1;
+        }
+        anyElliptical |= elliptical;
+        count++;
+    }
+    fclose(file);
+    if (failed) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        free(planets);
+        free(elements);
+        return -1;
+    }
+
+    releaseCatalog();
+    knownDestinations = planets;
+    knownDestinationsCount = count;
+    if (anyElliptical) {
+        catalogElements = elements;
+    } else {
+        free(elements);
+    }
+    if (buildCatalogOrbits(count) != 0 || buildCatalog() != 0) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        useBuiltinCatalog();
+        return -1;
+    }
+    return count;
+}
+
+int useDestinationCatalog(Planet *planets, const double *radii, const double *periods, int count,
+                          const int *nameSlots, unsigned nameMask, const OrbitalElements *elements) {
+    releaseCatalog();
+    if (elements != NULL) {
+        catalogElements = malloc(sizeof(OrbitalElements) * (count + 1));
+        if (catalogElements != NULL)
+            memcpy(catalogElements, elements, sizeof(OrbitalElements) * count);
+        if (catalogElements == NULL || buildCatalogOrbits(count) != 0) {
+            useBuiltinCatalog();
+            return -1;
+        }
+    }
+    knownDestinations = planets;
+    knownDestinationsCount = count;
+    destinationRadii = radii;
+    destinationPeriods = periods;
+    nameIndex = nameSlots;
+    nameIndexMask = nameMask;
+    catalogBorrowed = 1;
+    catalogReady = 1;
+    return 0;
+}
+
+unsigned getDestinationGeneration(void) {
+    return catalogGeneration;
+}
+
+unsigned getDestinationNameIndex(const int **slots) {
+    ensureCatalog();
+    *slots = nameIndex;
+    return nameIndexMask;
+}
+
+BodySet getDestinationBodySet(void) {
+    ensureCatalog();
+    BodySet bodies;
+    memset(&bodies, 0, sizeof(bodies));
+    bodies.orbitRadius = destinationRadii;
+    bodies.orbitalPeriod = destinationPeriods;
+    bodies.count = knownDestinationsCount;
+    if (catalogElements != NULL)
+        bodies.orbits = keplerSetOrbits(&catalogOrbits);
+    return bodies;
+}
+
+const OrbitalElements *getDestinationElements(int index) {
+    return catalogElements != NULL ? &catalogElements[index] : NULL;
+}
+
+Vector3D getDestinationPosition(int index, double time) {
+    return computeBodyPosition(getDestinationBodySet(), index, time, NULL);
+}
 
 void printDestinations(void) {
     printf("Loaded Destinations:\n");
@@ -25,11 +337,35 @@ void printDestinations(void) {
 }
 
 Planet *getDestinationByName(const char *name) {
-    for (int i = 0; i < knownDestinationsCount; i++) {
-        if (strcmp(knownDestinations[i].name, name) == 0) {
-            return &knownDestinations[i];
+    ensureCatalog();
+    unsigned slot = hashName(name) & nameIndexMask;
+    // Bounded too, in case a borrowed index has no empty slot.
+    for (unsigned probes = 0; probes <= nameIndexMask && nameIndex[slot] != -1; probes++) {
+        if (strcmp(knownDestinations[nameIndex[slot]].name, name) == 0) {
+            return &knownDestinations[nameIndex[slot]];
         }
+        slot = (slot + 1) & nameIndexMask;
     }
     return NULL;  // Not found.
 }
 
+// Sun-to-planet mass ratios of the major planets (Earth includes the Moon).
+static const struct {
+    const char *name;
+    double massRatio;
+} majorPlanets[] = {
+    { "Mercury", 6023600.0 }, { "Venus", 408523.71 }, { "Earth", 328900.56 }, { "Mars", 3098708.0 },
+    { "Jupiter", 1047.3486 }, { "Saturn", 3497.898 }, { "Uranus", 22902.98 }, { "Neptune", 19412.24 }
+};
+
+int getDestinationPerturbers(Planet *planets, double *gm, int max) {
+    int count = 0;
+    for (size_t p = 0; p < sizeof(majorPlanets) / sizeof(majorPlanets[0]) && count < max; p++) {
+        Planet *planet = getDestinationByName(majorPlanets[p].name);
+        if (planet == NULL)
+            continue;
+        planets[count] = *planet;
+        gm[count++] = SUN_GM / majorPlanets[p].massRatio;
+    }
+    return count;
+}
@@ -2,17 +2,57 @@
 #define DESTINATIONS_H
 
 #include "planet.h"
+#include "ephemeris.h"
 
 // Array of known destinations (planets, etc.)
-extern Planet knownDestinations[];
+// Points at the built-in planet list until a catalog file is loaded.
+extern Planet *knownDestinations;
 
 // Number of known destinations.
 extern int knownDestinationsCount;
 
+// Loads a catalog file, replacing the known destinations.
+// Each line is "<name> <orbit radius AU> <orbital period days>", optionally
+// followed by "<eccentricity> <inclination> <ascending node> <argument of
+// periapsis> <mean anomaly at time 0>" (angles in degrees) for a Keplerian
+// orbit whose semi-major axis is the radius; '#' starts a comment.
+// Returns the number of destinations loaded, or -1 on error.
+int loadDestinations(const char *path);
+
+// Serves the known destinations from storage owned by the caller, such as a
+// mapped ephemeris file, including a name index built by this module.
+// The storage must outlive its use as the catalog and is never written.
+// elements (copied) gives every body's Keplerian orbit, or is NULL if all
+// orbits are circular. Returns 0, or -1 on allocation failure, which leaves
+// the built-in planets as the catalog.
+int useDestinationCatalog(Planet *planets, const double *radii, const double *periods, int count,
+                          const int *nameSlots, unsigned nameMask, const OrbitalElements *elements);
+
+// Changes whenever the catalog is replaced, so caches over it can tell they
+// are stale even if the new storage reuses the old addresses.
+unsigned getDestinationGeneration(void);
+
+// Name index of the current catalog (slot -> index, -1 if empty), for writers
+// that persist it. Returns the slot mask (slot count - 1).
+unsigned getDestinationNameIndex(const int **slots);
+
+// Structure-of-arrays view (radius, period, Keplerian orbits if any) of the known destinations.
+BodySet getDestinationBodySet(void);
+
+// Orbital elements of a destination, or NULL if the catalog has only circular orbits.
+const OrbitalElements *getDestinationElements(int index);
+
+// Position of a destination at time, on its Keplerian orbit if it has one.
+Vector3D getDestinationPosition(int index, double time);
+
 // Function to print all loaded destinations.
 void printDestinations(void);
 
-// Helper function: Find a destination by name.
+// Helper function: Find a destination by name (hashed lookup).
 Planet *getDestinationByName(const char *name);
 
+// The catalog's major planets, by name, with their gravitational parameters
+// (AU^3/day^2), as perturbers for propagateShips. Returns how many (<= max).
+int getDestinationPerturbers(Planet *planets, double *gm, int max);
+
 #endif
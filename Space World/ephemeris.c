@@ -0,0 +1,104 @@
+#include "ephemeris.h"
+
+#define KEPLER_BLOCK 256
+
+// Float32 variant: degree 9/8 polynomials, truncation error below 3e-8.
+static inline void sinCosKernelF(double turns, float *s, float *c) {
+    int quadrant;
+    float x = (float)reduceTurns(turns, &quadrant);
+    float x2 = x * x;
+    float sp = x * (1.0f + x2 * (-1.0f / 6 + x2 * (1.0f / 120 + x2 * (-1.0f / 5040
+             + x2 * (1.0f / 362880)))));
+    float cp = 1.0f + x2 * (-1.0f / 2 + x2 * (1.0f / 24 + x2 * (-1.0f / 720
+             + x2 * (1.0f / 40320))));
+    float sv = (quadrant & 1) ? cp : sp;
+    float cv = (quadrant & 1) ? sp : cp;
+    *s = ((quadrant + 0) & 2) ? -sv : sv;
+    *c = ((quadrant + 1) & 2) ? -cv : cv;
+}
+
+void sinCosTurns(const double *turns, int count, double *s, double *c) {
+    for (int i = 0; i < count; i++) {
+        sinCosKernel(turns[i], &s[i], &c[i]);
+    }
+}
+
+void computePositionsBatch(BodySet bodies, const double *times, int timeCount,
+                           double *x, double *y, double *z) {
+    NAV_COUNT(NAV_COUNT_BATCH_POSITIONS, (unsigned long long)bodies.count * timeCount);
+    const double *radius = bodies.orbitRadius;
+    const double *period = bodies.orbitalPeriod;
+    if (bodies.orbits.eccentricity != NULL) {
+        for (int t = 0; t < timeCount; t++) {
+            long row = (long)t * bodies.count;
+            keplerPositions(bodies.orbits, period, bodies.count, times[t], x + row, y + row, z + row);
+        }
+        return;
+    }
+    for (int t = 0; t < timeCount; t++) {
+        double time = times[t];
+        double *restrict px = x + (long)t * bodies.count;
+        double *restrict py = y + (long)t * bodies.count;
+        double *restrict pz = z + (long)t * bodies.count;
+        for (int i = 0; i < bodies.count; i++) {
+            double s, c;
+            sinCosKernel(time / period[i], &s, &c);
+            px[i] = radius[i] * c;
+            py[i] = radius[i] * s;
+            pz[i] = 0.0;
+        }
+    }
+}
+
+Vector3D computeBodyPosition(BodySet bodies, int body, double time, Vector3D *velocity) {
+    if (bodies.orbits.eccentricity != NULL)
+        return keplerOrbitPosition(bodies.orbits, body, bodies.orbitalPeriod[body], time, velocity);
+    double s, c, radius = bodies.orbitRadius[body];
+    sinCosKernel(time / bodies.orbitalPeriod[body], &s, &c);
+    Vector3D pos = { radius * c, radius * s, 0.0 };
+    if (velocity != NULL) {
+        double rate = TWO_PI / bodies.orbitalPeriod[body];
+        velocity->x = -rate * pos.y;
+        velocity->y = rate * pos.x;
+        velocity->z = 0.0;
+    }
+    return pos;
+}
+
+void computePositionsBatchF(BodySet bodies, const double *times, int timeCount,
+                            float *x, float *y, float *z) {
+    NAV_COUNT(NAV_COUNT_BATCH_POSITIONS, (unsigned long long)bodies.count * timeCount);
+    const double *radius = bodies.orbitRadius;
+    const double *period = bodies.orbitalPeriod;
+    if (bodies.orbits.eccentricity != NULL) {
+        // Kepler's equation needs double precision; solve in blocks and narrow.
+        double bx[KEPLER_BLOCK], by[KEPLER_BLOCK], bz[KEPLER_BLOCK];
+        for (int t = 0; t < timeCount; t++) {
+            long row = (long)t * bodies.count;
+            for (int first = 0; first < bodies.count; first += KEPLER_BLOCK) {
+                int count = bodies.count - first < KEPLER_BLOCK ? bodies.count - first : KEPLER_BLOCK;
+                keplerPositions(keplerOrbitsSlice(bodies.orbits, first), period + first, count,
+                                times[t], bx, by, bz);
+                for (int i = 0; i < count; i++) {
+                    x[row + first + i] = (float)bx[i];
+                    y[row + first + i] = (float)by[i];
+                    z[row + first + i] = (float)bz[i];
+                }
+            }
+        }
+        return;
+    }
+    for (int t = 0; t < timeCount; t++) {
+        double time = times[t];
+        float *restrict px = x + (long)t * bodies.count;
+        float *restrict py = y + (long)t * bodies.count;
+        float *restrict pz = z + (long)t * bodies.count;
+        for (int i = 0; i < bodies.count; i++) {
+            float s, c;
+            sinCosKernelF(time / period[i], &s, &c);
+            px[i] = (float)radius[i] * c;
+            py[i] = (float)radius[i] * s;
+            pz[i] = 0.0f;
+        }
+    }
+}
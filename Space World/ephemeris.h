@@ -0,0 +1,83 @@
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include "planet.h"
+#include "kepler.h"
+#include <stddef.h>
+
+// Structure-of-arrays view of a set of bodies for batched position queries.
+// Bodies move on circular orbits in the z = 0 plane unless orbits is set.
+typedef struct {
+    const double *orbitRadius;    // in AU (semi-major axis for Keplerian orbits)
+    const double *orbitalPeriod;  // in days
+    int count;
+    KeplerOrbits orbits;          // orbits.eccentricity == NULL: circular orbits
+} BodySet;
+
+// The bodies [first, first + count) of a set.
+static inline BodySet bodySetSlice(BodySet bodies, int first, int count) {
+    BodySet slice = { bodies.orbitRadius + first, bodies.orbitalPeriod + first, count, bodies.orbits };
+    if (bodies.orbits.eccentricity != NULL)
+        slice.orbits = keplerOrbitsSlice(bodies.orbits, first);
+    return slice;
+}
+
+// Adding and subtracting 1.5 * 2^52 rounds to the nearest integer without
+// a libm call, which keeps loops that use it vectorizable. Valid for |v| < 2^51.
+#define ROUND_MAGIC 6755399441055744.0
+
+static inline double roundNearest(double v) {
+    return (v + ROUND_MAGIC) - ROUND_MAGIC;
+}
+
+#define TWO_PI 6.283185307179586
+
+// Splits an angle given in turns into a quadrant (0..3) and a remainder
+// in [-PI/4, PI/4] radians. Working in turns keeps the reduction exact.
+static inline double reduceTurns(double turns, int *quadrant) {
+    double f = turns - roundNearest(turns);  // [-0.5, 0.5] turns
+    double q = roundNearest(4.0 * f);        // -2..2
+    *quadrant = (int)q & 3;
+    return (f - 0.25 * q) * TWO_PI;
+}
+
+// sin and cos of (2 * PI * turns). Taylor polynomials on [-PI/4, PI/4];
+// truncation error is below 1e-16. Branch-free, for use in vectorized loops.
+static inline void sinCosKernel(double turns, double *s, double *c) {
+    int quadrant;
+    double x = reduceTurns(turns, &quadrant);
+    double x2 = x * x;
+    double sp = x * (1.0 + x2 * (-1.0 / 6 + x2 * (1.0 / 120 + x2 * (-1.0 / 5040
+              + x2 * (1.0 / 362880 + x2 * (-1.0 / 39916800 + x2 * (1.0 / 6227020800.0
+              + x2 * (-1.0 / 1307674368000.0))))))));
+    double cp = 1.0 + x2 * (-1.0 / 2 + x2 * (1.0 / 24 + x2 * (-1.0 / 720 + x2 * (1.0 / 40320
+              + x2 * (-1.0 / 3628800 + x2 * (1.0 / 479001600 + x2 * (-1.0 / 87178291200.0
+              + x2 * (1.0 / 20922789888000.0))))))));
+    double sv = (quadrant & 1) ? cp : sp;
+    double cv = (quadrant & 1) ? sp : cp;
+    *s = ((quadrant + 0) & 2) ? -sv : sv;
+    *c = ((quadrant + 1) & 2) ? -cv : cv;
+}
+
+// Computes sin and cos of (2 * PI * turns[i]) for count values.
+// Branch-free, so the loop vectorizes (SSE/AVX/NEON) at -O2 and above.
+void sinCosTurns(const double *turns, int count, double *s, double *c);
+
+// Fills x/y/z with the position of every body at every time.
+// Output is row-major by time: index = t * bodies.count + body,
+// so each array must hold timeCount * bodies.count values.
+void computePositionsBatch(BodySet bodies, const double *times, int timeCount,
+                           double *x, double *y, double *z);
+
+// Position of one body of the set at time and, if velocity is not NULL,
+// its velocity (AU/day).
+Vector3D computeBodyPosition(BodySet bodies, int body, double time, Vector3D *velocity);
+
+// Same as computePositionsBatch but evaluates the trig in float32.
+// Angles are still reduced in double, so the error does not grow with time:
+// |error| <= 5e-7 * orbitRadius AU per coordinate. Keplerian orbits are
+// solved in double and only the results are narrowed.
+void computePositionsBatchF(BodySet bodies, const double *times, int timeCount,
+                            float *x, float *y, float *z);
+
+#endif
@@ -0,0 +1,278 @@
+#include "ephemfile.h"
+#include "destinations.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + EPHEMERIS_FILE_ALIGN - 1) & ~(uint64_t)(EPHEMERIS_FILE_ALIGN - 1);
+}
+
+// Writes one section at its offset, zero-padding the gap before it.
+static int writeSection(FILE *out, uint64_t *position, uint64_t offset, const void *data, size_t bytes) {
+    static const char padding[EPHEMERIS_FILE_ALIGN];
+    while (*position < offset) {
+        size_t gap = offset - *position;
+        if (gap > sizeof(padding))
+            gap = sizeof(padding);
+        if (fwrite(padding, 1, gap, out) != gap)
+            return -1;
+        *position += gap;
+    }
+    if (bytes > 0 && fwrite(data, 1, bytes, out) != bytes)
+        return -1;
+    *position += bytes;
+    return 0;
+}
+
+int writeEphemerisFile(const char *path, const EphemerisCache *cache) {
+    BodySet bodies = getDestinationBodySet();
+    if (cache->bodyCount != bodies.count) {
+        fprintf(stderr, "%s: cache does not match the destination catalog\n", path);
+        return -1;
+    }
+    const OrbitalElements *elements = bodies.count > 0 ? getDestinationElements(0) : NULL;
+    const int *nameSlots;
+    uint64_t nameMask = getDestinationNameIndex(&nameSlots);
+    uint64_t count = (uint64_t)bodies.count;
+
+    // Segment counts and offsets are stored with fixed widths.
+    int32_t *segmentCount = malloc(sizeof(int32_t) * (count + 1));
+    int64_t *coeffOffset = malloc(sizeof(int64_t) * (count + 1));
+    if (!segmentCount || !coeffOffset) {
+        free(segmentCount);
+        free(coeffOffset);
+        return -1;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        segmentCount[i] = cache->segmentCount[i];
+        coeffOffset[i] = cache->coeffOffset[i];
+    }
+
+    EphemerisFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EPHEMERIS_FILE_MAGIC, sizeof(header.magic));
+    header.version = EPHEMERIS_FILE_VERSION;
+    header.byteOrder = EPHEMERIS_FILE_BYTE_ORDER;
+    header.bodyCount = bodies.count;
+    header.degree = cache->degree;
+    header.startTime = cache->startTime;
+    header.endTime = cache->endTime;
+    header.planetsOffset = alignUp(sizeof(header));
+    header.radiusOffset = alignUp(header.planetsOffset + count * sizeof(Planet));
+    header.periodOffset = alignUp(header.radiusOffset + count * sizeof(double));
+    header.nameIndexOffset = alignUp(header.periodOffset + count * sizeof(double));
+    header.nameIndexMask = nameMask;
+    header.segmentLengthOffset = alignUp(header.nameIndexOffset + (nameMask + 1) * sizeof(int32_t));
+    header.segmentCountOffset = alignUp(header.segmentLengthOffset + count * sizeof(double));
+    header.coeffOffsetOffset = alignUp(header.segmentCountOffset + count * sizeof(int32_t));
+    header.coeffsOffset = alignUp(header.coeffOffsetOffset + count * sizeof(int64_t));
+    header.coeffCount = (uint64_t)cache->coeffCount;
+    header.fileSize = header.coeffsOffset + header.coeffCount * sizeof(double);
+    if (elements != NULL) {
+        header.elementsOffset = alignUp(header.fileSize);
+        header.fileSize = header.elementsOffset + count * sizeof(OrbitalElements);
+    }
+
+    // Write a temporary file in the same directory and rename it over path,
+    // so a process that has the old file mapped keeps reading the old pages
+    // instead of a truncated file (SIGBUS).
+    size_t pathLength = strlen(path);
+    char *temporary = malloc(pathLength + sizeof(".XXXXXX"));
+    int fd = -1;
+    if (temporary != NULL) {
+        memcpy(temporary, path, pathLength);
+        memcpy(temporary + pathLength, ".XXXXXX", sizeof(".XXXXXX"));
+        fd = mkstemp(temporary);
+    }
+    FILE *out = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (out == NULL) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+            unlink(temporary);
+        }
+        free(temporary);
+        free(segmentCount);
+        free(coeffOffset);
+        return -1;
+    }
+    // mkstemp creates the file 0600; give it the mode fopen would have.
+    mode_t mask = umask(0);
+    umask(mask);
+    fchmod(fd, 0666 & ~mask);
+    uint64_t position = 0;
+    int status = 0;
+    status |= writeSection(out, &position, 0, &header, sizeof(header));
+    status |= writeSection(out, &position, header.planetsOffset, knownDestinations, count * sizeof(Planet));
+    status |= writeSection(out, &position, header.radiusOffset, bodies.orbitRadius, count * sizeof(double));
+    status |= writeSection(out, &position, header.periodOffset, bodies.orbitalPeriod, count * sizeof(double));
+    status |= writeSection(out, &position, header.nameIndexOffset, nameSlots, (nameMask + 1) * sizeof(int32_t));
+    status |= writeSection(out, &position, header.segmentLengthOffset, cache->segmentLength, count * sizeof(double));
+    status |= writeSection(out, &position, header.segmentCountOffset, segmentCount, count * sizeof(int32_t));
+    status |= writeSection(out, &position, header.coeffOffsetOffset, coeffOffset, count * sizeof(int64_t));
+    status |= writeSection(out, &position, header.coeffsOffset, cache->coeffs, header.coeffCount * sizeof(double));
+    if (elements != NULL)
+        status |= writeSection(out, &position, header.elementsOffset, elements, count * sizeof(OrbitalElements));
+    if (fclose(out) != 0)
+        status = -1;
+    if (status == 0 && rename(temporary, path) != 0)
+        status = -1;
+    free(segmentCount);
+    free(coeffOffset);
+    if (status != 0) {
+        fprintf(stderr, "%s: write failed\n", path);
+        unlink(temporary);
+        free(temporary);
+        return -1;
+    }
+    free(temporary);
+    return 0;
+}
+
+// Checks that a section lies inside the file and is aligned.
+static int sectionValid(const EphemerisFileHeader *header, uint64_t offset, uint64_t count, uint64_t size) {
+    return offset % EPHEMERIS_FILE_ALIGN == 0 && offset <= header->fileSize &&
+           count <= (header->fileSize - offset) / size;
+}
+
+static int headerValid(const EphemerisFileHeader *header, size_t fileSize) {
+    uint64_t count = (uint64_t)header->bodyCount;
+    return memcmp(header->magic, EPHEMERIS_FILE_MAGIC, sizeof(header->magic)) == 0 &&
+           header->version == EPHEMERIS_FILE_VERSION &&
+           header->byteOrder == EPHEMERIS_FILE_BYTE_ORDER &&
+           header->fileSize == fileSize && header->bodyCount >= 0 &&
+           header->degree >= 1 && header->degree <= 32 &&
+           header->nameIndexMask < UINT32_MAX && ((header->nameIndexMask + 1) & header->nameIndexMask) == 0 &&
+           sectionValid(header, header->planetsOffset, count, sizeof(Planet)) &&
+           sectionValid(header, header->radiusOffset, count, sizeof(double)) &&
+           sectionValid(header, header->periodOffset, count, sizeof(double)) &&
+           sectionValid(header, header->nameIndexOffset, header->nameIndexMask + 1, sizeof(int32_t)) &&
+           sectionValid(header, header->segmentLengthOffset, count, sizeof(double)) &&
+           sectionValid(header, header->segmentCountOffset, count, sizeof(int32_t)) &&
+           sectionValid(header, header->coeffOffsetOffset, count, sizeof(int64_t)) &&
+           sectionValid(header, header->coeffsOffset, header->coeffCount, sizeof(double)) &&
+           (header->elementsOffset == 0 ||
+            sectionValid(header, header->elementsOffset, count, sizeof(OrbitalElements)));
+}
+
+// Checks every body's name, orbit, segments, coefficient range and
+// name-index slot against the file.
+static int bodiesValid(const EphemerisFileHeader *header, const char *bytes) {
+    const Planet *planets = (const Planet *)(bytes + header->planetsOffset);
+    const double *radius = (const double *)(bytes + header->radiusOffset);
+    const double *period = (const double *)(bytes + header->periodOffset);
+    const double *segmentLength = (const double *)(bytes + header->segmentLengthOffset);
+    const int32_t *segmentCount = (const int32_t *)(bytes + header->segmentCountOffset);
+    const int64_t *coeffOffset = (const int64_t *)(bytes + header->coeffOffsetOffset);
+    int64_t perSegment = 3 * (int64_t)(header->degree + 1);
+    for (int32_t i = 0; i < header->bodyCount; i++) {
+        if (memchr(planets[i].name, '\0', sizeof(planets[i].name)) == NULL)
+            return 0;
+        // Periods and segment lengths are divided by.
+        if (!(isfinite(radius[i]) && radius[i] >= 0.0) || !(isfinite(period[i]) && period[i] > 0.0) ||
+            !(isfinite(segmentLength[i]) && segmentLength[i] > 0.0))
+            return 0;
+        if (segmentCount[i] < 1 || coeffOffset[i] < 0 ||
+            (uint64_t)coeffOffset[i] > header->coeffCount ||
+            (uint64_t)segmentCount[i] * perSegment > header->coeffCount - (uint64_t)coeffOffset[i])
+            return 0;
+    }
+    if (header->elementsOffset != 0) {
+        const OrbitalElements *elements = (const OrbitalElements *)(bytes + header->elementsOffset);
+        for (int32_t i = 0; i < header->bodyCount; i++) {
+            const OrbitalElements *e = &elements[i];
+            if (!(e->eccentricity >= 0.0 && e->eccentricity < 1.0) || !(e->period > 0.0) ||
+                !isfinite(e->semiMajorAxis) || !isfinite(e->inclination) || !isfinite(e->ascendingNode) ||
+                !isfinite(e->argumentOfPeriapsis) || !isfinite(e->meanAnomaly) || !isfinite(e->period))
+                return 0;
+        }
+    }
+    // An empty slot ends every probe sequence.
+    const int32_t *nameSlots = (const int32_t *)(bytes + header->nameIndexOffset);
+    int emptySlot = 0;
+    for (uint64_t slot = 0; slot <= header->nameIndexMask; slot++) {
+        if (nameSlots[slot] < -1 || nameSlots[slot] >= header->bodyCount)
+            return 0;
+        emptySlot |= nameSlots[slot] == -1;
+    }
+    return emptySlot;
+}
+
+int openEphemerisFile(const char *path, EphemerisFile *file) {
+    memset(file, 0, sizeof(*file));
+    // The cache view reads the on-disk offset and count tables in place.
+    if (sizeof(long) != sizeof(int64_t) || sizeof(int) != sizeof(int32_t)) {
+        fprintf(stderr, "%s: unsupported platform integer sizes\n", path);
+        return -1;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(EphemerisFileHeader)) {
+        fprintf(stderr, "%s: not an ephemeris file\n", path);
+        close(fd);
+        return -1;
+    }
+    void *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    const EphemerisFileHeader *header = base;
+    if (!headerValid(header, (size_t)info.st_size) || !bodiesValid(header, base)) {
+        fprintf(stderr, "%s: invalid or incompatible ephemeris file\n", path);
+        munmap(base, (size_t)info.st_size);
+        return -1;
+    }
+
+    file->base = base;
+    file->size = (size_t)info.st_size;
+    file->header = header;
+
+    // The cache and catalog point straight into the read-only mapping.
+    char *bytes = base;
+    EphemerisCache *cache = &file->cache;
+    cache->startTime = header->startTime;
+    cache->endTime = header->endTime;
+    cache->degree = header->degree;
+    cache->bodyCount = header->bodyCount;
+    cache->orbitRadius = (double *)(bytes + header->radiusOffset);
+    cache->orbitalPeriod = (double *)(bytes + header->periodOffset);
+    cache->segmentLength = (double *)(bytes + header->segmentLengthOffset);
+    cache->segmentCount = (int *)(bytes + header->segmentCountOffset);
+    cache->coeffOffset = (long *)(bytes + header->coeffOffsetOffset);
+    cache->coeffs = (double *)(bytes + header->coeffsOffset);
+    cache->coeffCount = (long)header->coeffCount;
+
+    const OrbitalElements *elements =
+        header->elementsOffset != 0 ? (const OrbitalElements *)(bytes + header->elementsOffset) : NULL;
+    if (useDestinationCatalog((Planet *)(bytes + header->planetsOffset), cache->orbitRadius,
+                              cache->orbitalPeriod, header->bodyCount,
+                              (const int *)(bytes + header->nameIndexOffset),
+                              (unsigned)header->nameIndexMask, elements) != 0) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        closeEphemerisFile(file);
+        return -1;
+    }
+    // The analytic fallback follows the same orbits as the catalog.
+    cache->orbits = getDestinationBodySet().orbits;
+    return 0;
+}
+
+void closeEphemerisFile(EphemerisFile *file) {
+    if (file->base != NULL)
+        munmap(file->base, file->size);
+    memset(file, 0, sizeof(*file));
+}
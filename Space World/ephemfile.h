@@ -0,0 +1,57 @@
+#ifndef EPHEMFILE_H
+#define EPHEMFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "planet.h"
+#include "chebyshev.h"
+
+#define EPHEMERIS_FILE_MAGIC "SPNEPHEM"
+#define EPHEMERIS_FILE_VERSION 2  // 2: Keplerian orbital elements
+#define EPHEMERIS_FILE_ALIGN 64
+#define EPHEMERIS_FILE_BYTE_ORDER 0x01020304u
+
+// On-disk header. Every section starts on an EPHEMERIS_FILE_ALIGN boundary,
+// and all offsets are in bytes from the start of the file.
+typedef struct {
+    char magic[8];             // EPHEMERIS_FILE_MAGIC, not NUL-terminated
+    uint32_t version;          // EPHEMERIS_FILE_VERSION
+    uint32_t byteOrder;        // EPHEMERIS_FILE_BYTE_ORDER as written by the producer
+    int32_t bodyCount;
+    int32_t degree;            // Chebyshev degree of every segment
+    double startTime, endTime; // cached span, in days
+    uint64_t planetsOffset;    // Planet[bodyCount]
+    uint64_t radiusOffset;     // double[bodyCount]
+    uint64_t periodOffset;     // double[bodyCount]
+    uint64_t nameIndexOffset;  // int32_t[nameIndexMask + 1], open-addressing name hash
+    uint64_t nameIndexMask;
+    uint64_t segmentLengthOffset; // double[bodyCount]
+    uint64_t segmentCountOffset;  // int32_t[bodyCount]
+    uint64_t coeffOffsetOffset;   // int64_t[bodyCount]
+    uint64_t coeffsOffset;        // double[coeffCount]
+    uint64_t coeffCount;
+    uint64_t elementsOffset;      // OrbitalElements[bodyCount], 0 if every orbit is circular
+    uint64_t fileSize;
+} EphemerisFileHeader;
+
+// A read-only mapped ephemeris file.
+typedef struct {
+    void *base;
+    size_t size;
+    const EphemerisFileHeader *header;
+    EphemerisCache cache;  // points into the mapping; never pass to ephemerisCacheFree
+} EphemerisFile;
+
+// Writes the known destinations and a cache built over them. The file is
+// replaced by a rename, so processes that have the old one open keep it.
+// Returns 0 on success, -1 on error.
+int writeEphemerisFile(const char *path, const EphemerisCache *cache);
+
+// Maps a file read-only and validates it. On success the known destinations
+// are served straight from the mapping. Returns 0 on success, -1 on error.
+int openEphemerisFile(const char *path, EphemerisFile *file);
+
+// Unmaps the file. Load another catalog first if the destinations are still in use.
+void closeEphemerisFile(EphemerisFile *file);
+
+#endif
@@ -0,0 +1,366 @@
+// Exports ephemeris tables for the destination catalog.
+// Build and run with: ./build.sh export [-f csv|binary] [-o FILE] start end interval [body...]
+#include "export.h"
+#include "planet.h"
+#include "ephemeris.h"
+#include "destinations.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BLOCK_VALUES 32768     // positions per block; sets the rows in a block
+#define BLOCKS_PER_THREAD 4    // blocks in flight per thread between writes
+#define TIME_DECIMALS 6        // days
+#define POSITION_DECIMALS 9    // AU
+#define CSV_NAME_LENGTH (2 * EPHEMERIS_TABLE_NAME_LENGTH + 3)  // quoted, quotes doubled
+#define CSV_ROW_LENGTH (CSV_NAME_LENGTH + 4 * 32)
+
+typedef struct {
+    int binary;
+    BodySet bodies;
+    const int *indices;              // catalog index of each body
+    char (*names)[CSV_NAME_LENGTH];  // as written in CSV rows
+    long rowCount;
+    int blockRows;
+    double startTime, interval;
+} ExportTable;
+
+// One block of rows, formatted by a worker and written in order.
+typedef struct {
+    long firstRow;
+    int rows;
+    double *times, *x, *y, *z;
+    char *data;
+    size_t length;
+} ExportBlock;
+
+typedef struct {
+    const ExportTable *table;
+    ExportBlock *blocks;
+} ExportJob;
+
+// The selected bodies, owned separately from the catalog.
+typedef struct {
+    double *radius, *period;
+    KeplerSet orbits;
+} BodySubset;
+
+void printUsage(const char *program) {
+    printf("Usage: %s [-c catalog] [-f csv|binary] [-o FILE] [-t threads] start end interval [body...]\n",
+           program);
+    printf("  start end        time span in days; rows are at start + k * interval up to end\n");
+    printf("  body...          destinations to export (default: the whole catalog)\n");
+    printf("  -c FILE          destination catalog file (default: built-in planets)\n");
+    printf("  -f FORMAT        csv (default) or binary, a columnar table described in export.h\n");
+    printf("  -o FILE          output file (default: standard output)\n");
+    printf("  -t N             worker threads (default: every CPU)\n");
+}
+
+// Appends value with a fixed number of decimals, much faster than printf.
+static char *appendFixed(char *p, double value, int decimals) {
+    static const double scales[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    double scaled = fabs(value) * scales[decimals];
+    if (!(scaled < 9e18))
+        return p + sprintf(p, "%.*e", decimals, value);
+    unsigned long long units = (unsigned long long)(scaled + 0.5);
+    char digits[24];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + units % 10);
+        units /= 10;
+    } while (units > 0 || n <= decimals);
+    if (value < 0.0 && (n > 1 || digits[0] != '0'))
+        *p++ = '-';
+    while (n > decimals)
+        *p++ = digits[--n];
+    if (decimals > 0) {
+        *p++ = '.';
+        while (n > 0)
+            *p++ = digits[--n];
+    }
+    return p;
+}
+
+static void formatCsvBlock(const ExportTable *table, ExportBlock *block) {
+    int count = table->bodies.count;
+    char *p = block->data;
+    for (int i = 0; i < block->rows; i++) {
+        char time[32];
+        size_t timeLength = (size_t)(appendFixed(time, block->times[i], TIME_DECIMALS) - time);
+        for (int b = 0; b < count; b++) {
+            size_t k = (size_t)i * count + b;
+            memcpy(p, time, timeLength);
+            p += timeLength;
+            *p++ = ',';
+            size_t nameLength = strlen(table->names[b]);
+            memcpy(p, table->names[b], nameLength);
+            p += nameLength;
+            *p++ = ',';
+            p = appendFixed(p, block->x[k], POSITION_DECIMALS);
+            *p++ = ',';
+            p = appendFixed(p, block->y[k], POSITION_DECIMALS);
+            *p++ = ',';
+            p = appendFixed(p, block->z[k], POSITION_DECIMALS);
+            *p++ = '\n';
+        }
+    }
+    block->length = (size_t)(p - block->data);
+}
+
+// Transposes the time-major positions into the block's columns.
+static void formatBinaryBlock(const ExportTable *table, ExportBlock *block) {
+    int count = table->bodies.count, rows = block->rows;
+    double *columns = (double *)block->data;
+    for (int b = 0; b < count; b++) {
+        double *x = columns + (size_t)3 * b * rows, *y = x + rows, *z = y + rows;
+        for (int i = 0; i < rows; i++) {
+            size_t k = (size_t)i * count + b;
+            x[i] = block->x[k];
+            y[i] = block->y[k];
+            z[i] = block->z[k];
+        }
+    }
+    block->length = sizeof(double) * 3 * (size_t)count * rows;
+}
+
+static void exportBlocks(void *context, int begin, int end) {
+    ExportJob *job = context;
+    const ExportTable *table = job->table;
+    for (int j = begin; j < end; j++) {
+        ExportBlock *block = &job->blocks[j];
+        // Each time comes from its row index, so long tables do not drift.
+        for (int i = 0; i < block->rows; i++)
+            block->times[i] = table->startTime + (double)(block->firstRow + i) * table->interval;
+        computePositionsBatch(table->bodies, block->times, block->rows, block->x, block->y, block->z);
+        if (table->binary)
+            formatBinaryBlock(table, block);
+        else
+            formatCsvBlock(table, block);
+    }
+}
+
+static int writeAll(FILE *out, const void *data, size_t bytes) {
+    return bytes == 0 || fwrite(data, 1, bytes, out) == bytes ? 0 : -1;
+}
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + EPHEMERIS_TABLE_ALIGN - 1) & ~(uint64_t)(EPHEMERIS_TABLE_ALIGN - 1);
+}
+
+static int writeBinaryHeader(FILE *out, const ExportTable *table) {
+    int count = table->bodies.count;
+    EphemerisTableHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EPHEMERIS_TABLE_MAGIC, sizeof(header.magic));
+    header.version = EPHEMERIS_TABLE_VERSION;
+    header.byteOrder = EPHEMERIS_TABLE_BYTE_ORDER;
+    header.bodyCount = count;
+    header.blockRows = table->blockRows;
+    header.rowCount = (uint64_t)table->rowCount;
+    header.startTime = table->startTime;
+    header.interval = table->interval;
+    header.namesOffset = alignUp(sizeof(header));
+    header.dataOffset = alignUp(header.namesOffset + (uint64_t)count * EPHEMERIS_TABLE_NAME_LENGTH);
+    header.fileSize = header.dataOffset + header.rowCount * count * 3 * sizeof(double);
+
+    size_t prefix = (size_t)header.dataOffset;
+    char *data = calloc(prefix, 1);
+    if (data == NULL)
+        return -1;
+    memcpy(data, &header, sizeof(header));
+    for (int b = 0; b < count; b++) {
+        const char *name = knownDestinations[table->indices[b]].name;
+        memcpy(data + header.namesOffset + (size_t)b * EPHEMERIS_TABLE_NAME_LENGTH, name,
+               strnlen(name, EPHEMERIS_TABLE_NAME_LENGTH - 1));
+    }
+    int status = writeAll(out, data, prefix);
+    free(data);
+    return status;
+}
+
+// Computes the table in rounds of blocks spread across threads, then writes
+// each round in row order with one large write per block.
+static int exportTable(FILE *out, const ExportTable *table, int threads) {
+    if (threads <= 0)
+        threads = parallelDefaultThreads();
+    int count = table->bodies.count, slots = threads * BLOCKS_PER_THREAD;
+    size_t values = (size_t)table->blockRows * count;
+    size_t bytes = table->binary ? sizeof(double) * 3 * values : CSV_ROW_LENGTH * values;
+    ExportBlock *blocks = calloc(slots, sizeof(ExportBlock));
+    int status = blocks != NULL ? 0 : -1;
+    for (int s = 0; status == 0 && s < slots; s++) {
+        blocks[s].times = malloc(sizeof(double) * table->blockRows);
+        blocks[s].x = malloc(sizeof(double) * values);
+        blocks[s].y = malloc(sizeof(double) * values);
+        blocks[s].z = malloc(sizeof(double) * values);
+        blocks[s].data = malloc(bytes);
+        if (!blocks[s].times || !blocks[s].x || !blocks[s].y || !blocks[s].z || !blocks[s].data)
+            status = -1;
+    }
+
+    if (status == 0)
+        status = table->binary ? writeBinaryHeader(out, table) : writeAll(out, "time,body,x,y,z\n", 16);
+    ExportJob job = { table, blocks };
+    for (long row = 0; status == 0 && row < table->rowCount;) {
+        int used = 0;
+        for (; used < slots && row < table->rowCount; used++) {
+            blocks[used].firstRow = row;
+            blocks[used].rows = (int)(table->rowCount - row < table->blockRows ? table->rowCount - row
+                                                                                  : table->blockRows);
+            row += blocks[used].rows;
+        }
+        parallelFor(used, 1, threads, exportBlocks, &job);
+        for (int s = 0; status == 0 && s < used; s++)
+            status = writeAll(out, blocks[s].data, blocks[s].length);
+    }
+
+    for (int s = 0; blocks != NULL && s < slots; s++) {
+        free(blocks[s].times);
+        free(blocks[s].x);
+        free(blocks[s].y);
+        free(blocks[s].z);
+        free(blocks[s].data);
+    }
+    free(blocks);
+    return status;
+}
+
+// Copies the orbits of the selected catalog bodies into their own body set.
+static int selectBodies(const int *indices, int count, BodySubset *subset, BodySet *bodies) {
+    subset->radius = malloc(sizeof(double) * (count + 1));
+    subset->period = malloc(sizeof(double) * (count + 1));
+    keplerSetInit(&subset->orbits);
+    if (subset->radius == NULL || subset->period == NULL)
+        return -1;
+    BodySet catalog = getDestinationBodySet();
+    for (int k = 0; k < count; k++) {
+        subset->radius[k] = catalog.orbitRadius[indices[k]];
+        subset->period[k] = catalog.orbitalPeriod[indices[k]];
+        const OrbitalElements *elements = getDestinationElements(indices[k]);
+        if (elements != NULL && keplerSetAdd(&subset->orbits, elements) < 0)
+            return -1;
+    }
+    memset(bodies, 0, sizeof(*bodies));
+    bodies->orbitRadius = subset->radius;
+    bodies->orbitalPeriod = subset->period;
+    bodies->count = count;
+    if (subset->orbits.count > 0)
+        bodies->orbits = keplerSetOrbits(&subset->orbits);
+    return 0;
+}
+
+// Writes name into out as a CSV field, quoted if it holds a comma or quote.
+static void csvName(const char *name, char *out) {
+    if (strpbrk(name, ",\"\n") == NULL) {
+        strcpy(out, name);
+        return;
+    }
+    *out++ = '"';
+    for (; *name != '\0'; name++) {
+        if (*name == '"')
+            *out++ = '"';
+        *out++ = *name;
+    }
+    *out++ = '"';
+    *out = '\0';
+}
+
+int main(int argc, char *argv[]) {
+    const char *catalogPath = NULL, *outputPath = NULL;
+    int binary = 0, threads = 0, option;
+    while ((option = getopt(argc, argv, "c:f:o:t:h")) != -1) {
+        if (option == 'c') {
+            catalogPath = optarg;
+        } else if (option == 'f' && (strcmp(optarg, "csv") == 0 || strcmp(optarg, "binary") == 0)) {
+            binary = strcmp(optarg, "binary") == 0;
+        } else if (option == 'o') {
+            outputPath = optarg;
+        } else if (option == 't') {
+            threads = atoi(optarg);
+        } else {
+            printUsage(argv[0]);
+            exit(option == 'h' ? 0 : 1);
+        }
+    }
+    if (argc - optind < 3) {
+        printUsage(argv[0]);
+        exit(1);
+    }
+    if (catalogPath != NULL && loadDestinations(catalogPath) < 0) {
+        fprintf(stderr, "Error: could not load destination catalog %s\n", catalogPath);
+        exit(1);
+    }
+
+    ExportTable table;
+    memset(&table, 0, sizeof(table));
+    table.binary = binary;
+    table.startTime = atof(argv[optind]);
+    table.interval = atof(argv[optind + 2]);
+    double endTime = atof(argv[optind + 1]);
+    if (!(table.interval > 0.0) || !(endTime >= table.startTime)) {
+        fprintf(stderr, "Error: need start <= end and interval > 0\n");
+        exit(1);
+    }
+    // Allow for rounding in the span so that end itself is included.
+    table.rowCount = (long)floor((endTime - table.startTime) / table.interval * (1.0 + 1e-12)) + 1;
+
+    // Select the bodies: every destination, or the ones named, in that order.
+    int count = argc - optind - 3;
+    if (count == 0)
+        count = getDestinationBodySet().count;
+    if (count == 0) {
+        fprintf(stderr, "Error: no destinations to export\n");
+        exit(1);
+    }
+    int *indices = malloc(sizeof(int) * (count + 1));
+    table.names = malloc(sizeof(*table.names) * (count + 1));
+    if (indices == NULL || table.names == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    for (int k = 0; k < count; k++) {
+        if (argc - optind > 3) {
+            Planet *planet = getDestinationByName(argv[optind + 3 + k]);
+            if (planet == NULL) {
+                fprintf(stderr, "Error: unknown destination %s\n", argv[optind + 3 + k]);
+                exit(1);
+            }
+            indices[k] = (int)(planet - knownDestinations);
+        } else {
+            indices[k] = k;
+        }
+        csvName(knownDestinations[indices[k]].name, table.names[k]);
+    }
+    table.indices = indices;
+    BodySubset subset;
+    if (selectBodies(indices, count, &subset, &table.bodies) != 0) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    table.blockRows = count < BLOCK_VALUES ? BLOCK_VALUES / count : 1;
+    if (table.blockRows > table.rowCount)
+        table.blockRows = (int)table.rowCount;
+
+    FILE *out = outputPath != NULL ? fopen(outputPath, "wb") : stdout;
+    if (out == NULL) {
+        perror(outputPath);
+        exit(1);
+    }
+    int status = exportTable(out, &table, threads);
+    if (fflush(out) != 0)
+        status = -1;
+    if (status != 0)
+        perror(outputPath != NULL ? outputPath : "stdout");
+    if (out != stdout && fclose(out) != 0)
+        status = -1;
+
+    free(subset.radius);
+    free(subset.period);
+    keplerSetFree(&subset.orbits);
+    free(indices);
+    free(table.names);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+
+// Binary ephemeris tables written by space_export -f binary.
+#define EPHEMERIS_TABLE_MAGIC "SPNTABLE"
+#define EPHEMERIS_TABLE_VERSION 1
+#define EPHEMERIS_TABLE_ALIGN 64
+#define EPHEMERIS_TABLE_BYTE_ORDER 0x01020304u
+#define EPHEMERIS_TABLE_NAME_LENGTH 32  // NUL-padded, like Planet.name
+
+// Row k is at time startTime + k * interval; times are not stored. Rows are
+// grouped into blocks of blockRows (the last one may be shorter), and each
+// block holds one column per body and axis: for body b of a block with r
+// rows, x[r], y[r], z[r] start at double (3 * b) * r of the block. Block j
+// starts at dataOffset + j * blockRows * bodyCount * 3 * sizeof(double).
+// Offsets are in bytes from the start of the file.
+typedef struct {
+    char magic[8];             // EPHEMERIS_TABLE_MAGIC, not NUL-terminated
+    uint32_t version;          // EPHEMERIS_TABLE_VERSION
+    uint32_t byteOrder;        // EPHEMERIS_TABLE_BYTE_ORDER as written by the producer
+    int32_t bodyCount;
+    int32_t blockRows;
+    uint64_t rowCount;
+    double startTime, interval; // in days
+    uint64_t namesOffset;      // char[bodyCount][EPHEMERIS_TABLE_NAME_LENGTH]
+    uint64_t dataOffset;
+    uint64_t fileSize;
+} EphemerisTableHeader;
+
+#endif
@@ -0,0 +1,128 @@
+#include "fleet.h"
+#include "destinations.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHIPS_PER_TASK 1024
+
+void fleetInit(Fleet *fleet, double time) {
+    memset(fleet, 0, sizeof(*fleet));
+    fleet->time = time;
+    spatialGridInit(&fleet->grid, ARRIVAL_THRESHOLD);
+}
+
+void fleetFree(Fleet *fleet) {
+    free(fleet->x);
+    free(fleet->y);
+    free(fleet->z);
+    free(fleet->vx);
+    free(fleet->vy);
+    free(fleet->vz);
+    free(fleet->destination);
+    free(fleet->arrivalTime);
+    spatialGridFree(&fleet->grid);
+    memset(fleet, 0, sizeof(*fleet));
+}
+
+static int fleetGrow(Fleet *fleet) {
+    int capacity = fleet->capacity ? fleet->capacity * 2 : 256;
+    double **columns[] = { &fleet->x, &fleet->y, &fleet->z, &fleet->vx, &fleet->vy, &fleet->vz,
+                           &fleet->arrivalTime };
+    for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++) {
+        double *grown = realloc(*columns[c], sizeof(double) * capacity);
+        if (grown == NULL)
+            return -1;
+        *columns[c] = grown;
+    }
+    int *destination = realloc(fleet->destination, sizeof(int) * capacity);
+    if (destination == NULL)
+        return -1;
+    fleet->destination = destination;
+    fleet->capacity = capacity;
+    return 0;
+}
+
+int fleetAddShip(Fleet *fleet, Vector3D position, Vector3D velocity) {
+    if (fleet->count == fleet->capacity && fleetGrow(fleet) != 0)
+        return -1;
+    int i = fleet->count++;
+    fleet->x[i] = position.x;
+    fleet->y[i] = position.y;
+    fleet->z[i] = position.z;
+    fleet->vx[i] = velocity.x;
+    fleet->vy[i] = velocity.y;
+    fleet->vz[i] = velocity.z;
+    fleet->destination[i] = -1;
+    fleet->arrivalTime[i] = fleet->time;
+    return i;
+}
+
+typedef struct {
+    Fleet *fleet;
+    double dt;
+    const PropagateOptions *options;  // NULL: straight lines
+    atomic_int failed;
+} AdvanceJob;
+
+// Moves ships [begin, end) and checks them against the destination grid.
+static void advanceShips(void *context, int begin, int end) {
+    AdvanceJob *job = context;
+    Fleet *fleet = job->fleet;
+    double dt = job->dt;
+    if (job->options != NULL) {
+        ShipBatch ships = { fleet->x, fleet->y, fleet->z, fleet->vx, fleet->vy, fleet->vz, fleet->count };
+        if (propagateShips(shipBatchSlice(ships, begin, end - begin), fleet->time - dt, dt, job->options) != 0)
+            atomic_store(&job->failed, 1);
+    } else {
+        for (int i = begin; i < end; i++) {
+            fleet->x[i] += fleet->vx[i] * dt;
+            fleet->y[i] += fleet->vy[i] * dt;
+            fleet->z[i] += fleet->vz[i] * dt;
+        }
+    }
+    for (int i = begin; i < end; i++) {
+        Vector3D pos = { fleet->x[i], fleet->y[i], fleet->z[i] };
+        int found = spatialGridNearest(&fleet->grid, pos, ARRIVAL_THRESHOLD, NULL);
+        if (found != fleet->destination[i]) {
+            fleet->destination[i] = found;
+            fleet->arrivalTime[i] = fleet->time;
+        }
+    }
+}
+
+int fleetAdvance(Fleet *fleet, double dt, int threads) {
+    if (spatialGridBuild(&fleet->grid, getDestinationBodySet(), fleet->time + dt) != 0)
+        return -1;
+    fleet->time += dt;
+    AdvanceJob job = { fleet, dt, NULL, 0 };
+    parallelFor(fleet->count, SHIPS_PER_TASK, threads, advanceShips, &job);
+    return 0;
+}
+
+int fleetPropagate(Fleet *fleet, double dt, const PropagateOptions *options, int threads) {
+    if (spatialGridBuild(&fleet->grid, getDestinationBodySet(), fleet->time + dt) != 0)
+        return -1;
+    fleet->time += dt;
+    AdvanceJob job = { fleet, dt, options, 0 };
+    parallelFor(fleet->count, SHIPS_PER_TASK, threads, advanceShips, &job);
+    return atomic_load(&job.failed) ? -1 : 0;
+}
+
+void fleetShipState(const Fleet *fleet, int ship, ShipState *state) {
+    memset(state, 0, sizeof(*state));
+    state->currentTime = fleet->time;
+    state->shipPosition.x = fleet->x[ship];
+    state->shipPosition.y = fleet->y[ship];
+    state->shipPosition.z = fleet->z[ship];
+    int found = fleet->destination[ship];
+    NavContext context;
+    navContextInit(&context, knownDestinations, getDestinationBodySet());
+    if (found >= 0) {
+        Vector3D position = { fleet->grid.x[found], fleet->grid.y[found], fleet->grid.z[found] };
+        navSetDestination(&context, state, found, position, fleet->arrivalTime[ship]);
+    } else {
+        navSetDestination(&context, state, -1, state->shipPosition, fleet->arrivalTime[ship]);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "planet.h"
+#include "spacenav.h"
+#include "spatial.h"
+#include "propagate.h"
+
+// Many ships in structure-of-arrays form, all sharing one clock.
+// Ships cruise in straight lines at their velocity, or fall under gravity
+// (fleetPropagate); after every step each ship's destination is updated like
+// updateCurrentDestination does for one.
+typedef struct {
+    int count, capacity;
+    double time;            // fleet epoch, in days
+    double *x, *y, *z;      // positions, in AU
+    double *vx, *vy, *vz;   // velocities, in AU/day
+    int *destination;       // index into knownDestinations, -1 if unknown
+    double *arrivalTime;    // when the current destination was reached
+    SpatialGrid grid;       // destinations at the fleet epoch
+} Fleet;
+
+void fleetInit(Fleet *fleet, double time);
+void fleetFree(Fleet *fleet);
+
+// Adds a ship and returns its index, or -1 on allocation failure.
+int fleetAddShip(Fleet *fleet, Vector3D position, Vector3D velocity);
+
+// Advances every ship by dt days on up to threads threads (<= 0: every CPU).
+// Ships are independent, so results do not depend on the thread count.
+// Returns 0, or -1 if the destination grid could not be allocated (the
+// fleet is left unchanged).
+int fleetAdvance(Fleet *fleet, double dt, int threads);
+
+// Advances every ship by dt days with propagateShips, on up to threads
+// threads (<= 0: every CPU). Returns 0, or -1 if any ship failed to propagate
+// or the destination grid could not be allocated.
+int fleetPropagate(Fleet *fleet, double dt, const PropagateOptions *options, int threads);
+
+// Copies one ship into a ShipState (destination name and position only).
+void fleetShipState(const Fleet *fleet, int ship, ShipState *state);
+
+#endif
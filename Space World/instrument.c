@@ -0,0 +1,167 @@
+#include "instrument.h"
+#include "planet.h"
+
+#ifdef SPACENAV_INSTRUMENT
+
+#include <ctype.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HISTOGRAM_BUCKETS 64  // bucket b holds latencies in [2^b, 2^(b+1)) ns
+#define COMMAND_SLOTS 128
+
+static const char *counterNames[COUNTER_COUNT] = {
+    "planet_position_calls", "batch_position_bodies", "arrival_position_bodies",
+    "determine_destination_calls",
+    "arrival_grid_rebuilds"
+};
+static const char *timerNames[TIMER_COUNT] = {
+    "determine_destination", "trig", "distance"
+};
+
+static _Atomic uint64_t counters[COUNTER_COUNT];
+static _Atomic uint64_t timerNs[TIMER_COUNT];
+static _Atomic uint64_t timerCalls[TIMER_COUNT];
+static _Atomic uint64_t histograms[COMMAND_SLOTS][HISTOGRAM_BUCKETS];
+static _Atomic uint64_t commandNs[COMMAND_SLOTS];
+static volatile sig_atomic_t dumpRequested = 0;
+
+uint64_t instrumentNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void instrumentCount(InstrumentCounter counter, uint64_t amount) {
+    atomic_fetch_add_explicit(&counters[counter], amount, memory_order_relaxed);
+}
+
+void instrumentAddTime(InstrumentTimer timer, uint64_t ns) {
+    atomic_fetch_add_explicit(&timerNs[timer], ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&timerCalls[timer], 1, memory_order_relaxed);
+}
+
+void instrumentCommandLatency(char command, uint64_t ns) {
+    int slot = toupper((unsigned char)command) & (COMMAND_SLOTS - 1);
+    int bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS - 1 && (ns >> (bucket + 1)) != 0)
+        bucket++;
+    atomic_fetch_add_explicit(&histograms[slot][bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&commandNs[slot], ns, memory_order_relaxed);
+}
+
+static void onSignal(int signal) {
+    (void)signal;
+    dumpRequested = 1;
+}
+
+// Receives libspacenav's position counts.
+static void countLibraryPositions(NavCount count, unsigned long long amount) {
+    instrumentCount(count == NAV_COUNT_PLANET_POSITION ? COUNTER_PLANET_POSITION : COUNTER_BATCH_POSITIONS,
+                    amount);
+}
+
+void instrumentInit(void) {
+    setNavCountHook(countLibraryPositions);
+    atexit(instrumentDump);
+    signal(SIGUSR1, onSignal);
+}
+
+void instrumentPollSignal(void) {
+    if (dumpRequested) {
+        dumpRequested = 0;
+        instrumentDump();
+    }
+}
+
+// Upper bound (ns) of the bucket holding the given fraction of the samples.
+static uint64_t percentile(const uint64_t *buckets, uint64_t total, double fraction) {
+    uint64_t target = (uint64_t)(fraction * total + 0.5), seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= target && seen > 0)
+            return (uint64_t)1 << (b + 1 < 64 ? b + 1 : 63);
+    }
+    return 0;
+}
+
+static void dumpText(FILE *out) {
+    fprintf(out, "--- space_navigator metrics ---\n");
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        fprintf(out, "%-30s %llu\n", counterNames[c], (unsigned long long)atomic_load(&counters[c]));
+    fprintf(out, "\n%-30s %12s %14s %12s\n", "timer", "calls", "total ns", "ns/call");
+    for (int t = 0; t < TIMER_COUNT; t++) {
+        uint64_t calls = atomic_load(&timerCalls[t]), ns = atomic_load(&timerNs[t]);
+        fprintf(out, "%-30s %12llu %14llu %12.1f\n", timerNames[t], (unsigned long long)calls,
+                (unsigned long long)ns, calls ? (double)ns / calls : 0.0);
+    }
+    fprintf(out, "\n%-8s %10s %12s %10s %10s %10s\n", "command", "count", "mean ns", "p50 <=", "p90 <=", "p99 <=");
+    for (int slot = 0; slot < COMMAND_SLOTS; slot++) {
+        uint64_t buckets[HISTOGRAM_BUCKETS], total = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+            total += buckets[b] = atomic_load(&histograms[slot][b]);
+        if (total == 0)
+            continue;
+        fprintf(out, "%-8c %10llu %12.1f %10llu %10llu %10llu\n", slot, (unsigned long long)total,
+                (double)atomic_load(&commandNs[slot]) / total,
+                (unsigned long long)percentile(buckets, total, 0.5),
+                (unsigned long long)percentile(buckets, total, 0.9),
+                (unsigned long long)percentile(buckets, total, 0.99));
+    }
+}
+
+static void dumpJson(FILE *out) {
+    fprintf(out, "{\"counters\": {");
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        fprintf(out, "%s\"%s\": %llu", c ? ", " : "", counterNames[c],
+                (unsigned long long)atomic_load(&counters[c]));
+    fprintf(out, "}, \"timers\": {");
+    for (int t = 0; t < TIMER_COUNT; t++)
+        fprintf(out, "%s\"%s\": {\"calls\": %llu, \"total_ns\": %llu}", t ? ", " : "", timerNames[t],
+                (unsigned long long)atomic_load(&timerCalls[t]), (unsigned long long)atomic_load(&timerNs[t]));
+    fprintf(out, "}, \"commands\": {");
+    int first = 1;
+    for (int slot = 0; slot < COMMAND_SLOTS; slot++) {
+        uint64_t total = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+            total += atomic_load(&histograms[slot][b]);
+        if (total == 0)
+            continue;
+        fprintf(out, "%s\"%c\": {\"count\": %llu, \"total_ns\": %llu, \"log2_ns_buckets\": {",
+                first ? "" : ", ", slot, (unsigned long long)total,
+                (unsigned long long)atomic_load(&commandNs[slot]));
+        int firstBucket = 1;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            uint64_t n = atomic_load(&histograms[slot][b]);
+            if (n == 0)
+                continue;
+            fprintf(out, "%s\"%d\": %llu", firstBucket ? "" : ", ", b, (unsigned long long)n);
+            firstBucket = 0;
+        }
+        fprintf(out, "}}");
+        first = 0;
+    }
+    fprintf(out, "}}\n");
+}
+
+void instrumentDump(void) {
+    const char *format = getenv("SPACENAV_METRICS");
+    const char *path = getenv("SPACENAV_METRICS_FILE");
+    FILE *out = path ? fopen(path, "a") : stderr;
+    if (out == NULL)
+        return;
+    if (format != NULL && strcmp(format, "json") == 0)
+        dumpJson(out);
+    else
+        dumpText(out);
+    if (out != stderr)
+        fclose(out);
+    else
+        fflush(out);
+}
+
+#endif
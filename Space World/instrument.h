@@ -0,0 +1,59 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+// Hot-path instrumentation. Build with -DSPACENAV_INSTRUMENT (INSTRUMENT=1 ./build.sh)
+// to enable it; otherwise every macro below expands to nothing. libspacenav
+// reports its position counts through setNavCountHook (planet.h), which
+// instrumentInit points at the counters here.
+//
+// Metrics are dumped at exit and whenever SIGUSR1 arrives (at the next command).
+// SPACENAV_METRICS=json selects JSON instead of text, and SPACENAV_METRICS_FILE
+// names the output file (default: stderr).
+
+typedef enum {
+    COUNTER_PLANET_POSITION,      // getPlanetPosition calls
+    COUNTER_BATCH_POSITIONS,      // bodies evaluated by computePositionsBatch
+    COUNTER_ARRIVAL_POSITIONS,    // bodies positioned for arrival-grid rebuilds
+    COUNTER_DETERMINE_DESTINATION,
+    COUNTER_ARRIVAL_GRID_REBUILDS,
+    COUNTER_COUNT
+} InstrumentCounter;
+
+typedef enum {
+    TIMER_DETERMINE_DESTINATION,  // whole call
+    TIMER_TRIG,                   // position evaluation (sin/cos) for arrival checks
+    TIMER_DISTANCE,               // nearest-body query and recording the destination
+    TIMER_COUNT
+} InstrumentTimer;
+
+#ifdef SPACENAV_INSTRUMENT
+
+#include <stdint.h>
+
+uint64_t instrumentNow(void);
+void instrumentCount(InstrumentCounter counter, uint64_t amount);
+void instrumentAddTime(InstrumentTimer timer, uint64_t ns);
+void instrumentCommandLatency(char command, uint64_t ns);
+void instrumentInit(void);        // installs the exit and SIGUSR1 dumps
+void instrumentPollSignal(void);  // dumps if SIGUSR1 arrived since the last poll
+void instrumentDump(void);
+
+#define INSTR_INIT() instrumentInit()
+#define INSTR_POLL() instrumentPollSignal()
+#define INSTR_COUNT(counter, amount) instrumentCount(counter, amount)
+#define INSTR_TIMER_START(name) uint64_t name##Start = instrumentNow()
+#define INSTR_TIMER_STOP(name, timer) instrumentAddTime(timer, instrumentNow() - name##Start)
+#define INSTR_COMMAND_STOP(name, command) instrumentCommandLatency(command, instrumentNow() - name##Start)
+
+#else
+
+#define INSTR_INIT() ((void)0)
+#define INSTR_POLL() ((void)0)
+#define INSTR_COUNT(counter, amount) ((void)0)
+#define INSTR_TIMER_START(name) ((void)0)
+#define INSTR_TIMER_STOP(name, timer) ((void)0)
+#define INSTR_COMMAND_STOP(name, command) ((void)0)
+
+#endif
+
+#endif
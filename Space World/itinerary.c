@@ -0,0 +1,476 @@
+#include "itinerary.h"
+#include "destinations.h"
+#include "ephemeris.h"
+#include "navigation.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESTARTS 32
+#define RESTART_CHOICES 3        // randomized greedy picks among this many best next stops
+#define MAX_SEGMENT 3            // longest run of stops moved by one or-opt step
+#define WINDOW 10                // stops reordered exactly at a time by the window search
+#define WINDOW_STEP 5
+#define DEFAULT_NODE_LIMIT 2000000L
+#define IMPROVEMENT 1e-9         // days; smaller gains are rounding noise
+
+// One ordered pair of bodies. Hohmann legs wait for the target to lead the
+// source by the transfer angle, i.e. for departure * rate + offset to be a
+// whole number of turns; phasing legs leave at once or wait for the bodies
+// to line up, whichever arrives first.
+typedef struct {
+    int phasing;
+    double flightTime;   // Hohmann time; 0 for phasing legs
+    double rate;         // 1 / targetPeriod - 1 / sourcePeriod, in turns per day
+    double offset;       // Hohmann: flightTime / targetPeriod - 0.5 turns
+    double sourcePeriod;
+} LegModel;
+
+// Node 0 is the start body and nodes 1..n the distinct targets.
+typedef struct {
+    int n;
+    int bodies[ITINERARY_MAX_STOPS + 1];
+    double startTime;
+    LegModel *legs;      // (n + 1) x (n + 1), row = source
+    double *minFlight;   // per node: shortest flight into it from any other node
+} Planner;
+
+static void legModelInit(LegModel *leg, const Planet *source, const Planet *target) {
+    leg->phasing = fabs(source->orbitRadius - target->orbitRadius) < 1e-6;
+    leg->rate = 1.0 / target->orbitalPeriod - 1.0 / source->orbitalPeriod;
+    leg->sourcePeriod = source->orbitalPeriod;
+    leg->flightTime = leg->phasing ? 0.0 : computeHohmannTransferTime(source->orbitRadius, target->orbitRadius);
+    leg->offset = leg->flightTime / target->orbitalPeriod - 0.5;
+}
+
+// Earliest arrival leaving at time or later. Every leg is FIFO: a later
+// start never arrives earlier, which the exact search relies on.
+static double legArrival(const LegModel *leg, double time, double *departure) {
+    if (leg->phasing) {
+        // Phasing now takes computePhasingTime on the bodies' positions at
+        // time. When the bodies drift apart faster than the ship closes
+        // the gap, waiting for them to line up arrives sooner.
+        double turns = time * leg->rate;
+        turns -= roundNearest(turns);
+        double now = time + fabs(turns) * leg->sourcePeriod;
+        double aligned = now;
+        if (leg->rate > 0.0)
+            aligned = time + (ceil(time * leg->rate) - time * leg->rate) / leg->rate;
+        else if (leg->rate < 0.0)
+            aligned = time + (time * leg->rate - floor(time * leg->rate)) / -leg->rate;
+        *departure = aligned < now ? aligned : time;
+        return aligned < now ? aligned : now;
+    }
+    double wait = 0.0;
+    double phase = time * leg->rate + leg->offset;
+    if (leg->rate > 0.0)
+        wait = (ceil(phase) - phase) / leg->rate;
+    else if (leg->rate < 0.0)
+        wait = (phase - floor(phase)) / -leg->rate;
+    *departure = time + wait;
+    return *departure + leg->flightTime;
+}
+
+double itineraryLegArrival(const Planet *source, const Planet *target, double time, double *departure) {
+    LegModel leg;
+    double ignored;
+    legModelInit(&leg, source, target);
+    return legArrival(&leg, time, departure ? departure : &ignored);
+}
+
+static inline double plannerArrival(const Planner *planner, int from, int to, double time) {
+    double departure;
+    return legArrival(&planner->legs[from * (planner->n + 1) + to], time, &departure);
+}
+
+// Arrival at the end of route (count node numbers) leaving node from at time.
+static double followRoute(const Planner *planner, int from, double time, const int *route, int count) {
+    for (int i = 0; i < count; i++) {
+        time = plannerArrival(planner, from, route[i], time);
+        from = route[i];
+    }
+    return time;
+}
+
+// Exact dynamic programming over (visited set, last stop) that reorders
+// nodes[0, count) to finish the fixed suffix after them as early as possible,
+// leaving node from at time. Every leg is FIFO (see legArrival), so an
+// earlier arrival never leads to a later finish and the earliest arrival
+// per state is enough.
+// Returns the finish time, or -1 if memory runs out.
+static double solveWindow(const Planner *planner, int from, double time, int *nodes, int count,
+                          const int *suffix, int suffixCount) {
+    size_t states = (size_t)1 << count;
+    double *arrival = malloc(sizeof(double) * states * count);
+    signed char *previous = malloc(states * count);
+    if (arrival == NULL || previous == NULL) {
+        free(arrival);
+        free(previous);
+        return -1.0;
+    }
+    for (size_t i = 0; i < states * count; i++)
+        arrival[i] = INFINITY;
+    for (int j = 0; j < count; j++) {
+        arrival[((size_t)1 << j) * count + j] = plannerArrival(planner, from, nodes[j], time);
+        previous[((size_t)1 << j) * count + j] = -1;
+    }
+
+    for (size_t mask = 1; mask < states; mask++) {
+        for (int j = 0; j < count; j++) {
+            double t = arrival[mask * count + j];
+            if (!(mask & ((size_t)1 << j)) || t == INFINITY)
+                continue;
+            for (int k = 0; k < count; k++) {
+                if (mask & ((size_t)1 << k))
+                    continue;
+                size_t next = (mask | ((size_t)1 << k)) * count + k;
+                double candidate = plannerArrival(planner, nodes[j], nodes[k], t);
+                if (candidate < arrival[next]) {
+                    arrival[next] = candidate;
+                    previous[next] = (signed char)j;
+                }
+            }
+        }
+    }
+
+    size_t mask = states - 1;
+    int last = 0;
+    double finish = INFINITY;
+    for (int j = 0; j < count; j++) {
+        double t = followRoute(planner, nodes[j], arrival[mask * count + j], suffix, suffixCount);
+        if (t < finish) {
+            finish = t;
+            last = j;
+        }
+    }
+    int order[ITINERARY_MAX_STOPS];
+    for (int i = count - 1; i >= 0; i--) {
+        order[i] = nodes[last];
+        int before = previous[mask * count + last];
+        mask &= ~((size_t)1 << last);
+        last = before;
+    }
+    memcpy(nodes, order, sizeof(int) * count);
+    free(arrival);
+    free(previous);
+    return finish;
+}
+
+// Restart r of the multi-start search writes its route to orders + r * n.
+typedef struct {
+    const Planner *planner;
+    int *orders;
+    double *arrivals;
+} RestartJob;
+
+static uint32_t nextRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Restart 0 is greedy by earliest arrival; the others pick each stop at
+// random among the RESTART_CHOICES earliest next stops.
+static void buildGreedy(const Planner *planner, int restart, int *order) {
+    int n = planner->n;
+    int visited[ITINERARY_MAX_STOPS + 1] = { 0 };
+    uint32_t seed = 2463534242u + 977u * (uint32_t)restart;
+    double time = planner->startTime;
+    int at = 0;
+    for (int i = 0; i < n; i++) {
+        int best[RESTART_CHOICES];
+        double bestTime[RESTART_CHOICES];
+        int found = 0;
+        for (int k = 1; k <= n; k++) {
+            if (visited[k])
+                continue;
+            double arrival = plannerArrival(planner, at, k, time);
+            int slot = found < RESTART_CHOICES ? found++ : RESTART_CHOICES;
+            while (slot > 0 && bestTime[slot - 1] > arrival) {
+                if (slot < RESTART_CHOICES) {
+                    best[slot] = best[slot - 1];
+                    bestTime[slot] = bestTime[slot - 1];
+                }
+                slot--;
+            }
+            if (slot < RESTART_CHOICES) {
+                best[slot] = k;
+                bestTime[slot] = arrival;
+            }
+        }
+        int pick = restart == 0 ? 0 : (int)(nextRandom(&seed) % (uint32_t)found);
+        order[i] = best[pick];
+        visited[best[pick]] = 1;
+        time = bestTime[pick];
+        at = best[pick];
+    }
+}
+
+// Times along order: prefix[i] is the arrival at the i-th stop (startTime for 0).
+static void routePrefix(const Planner *planner, const int *order, double *prefix) {
+    prefix[0] = planner->startTime;
+    for (int i = 0; i < planner->n; i++)
+        prefix[i + 1] = plannerArrival(planner, i > 0 ? order[i - 1] : 0, order[i], prefix[i]);
+}
+
+// Keeps candidate if it finishes earlier than order; both agree before position first.
+static int acceptCandidate(const Planner *planner, int *order, const int *candidate, int first,
+                           double *prefix) {
+    int n = planner->n;
+    double arrival = followRoute(planner, first > 0 ? candidate[first - 1] : 0, prefix[first],
+                                 candidate + first, n - first);
+    if (!(arrival < prefix[n] - IMPROVEMENT))
+        return 0;
+    memcpy(order, candidate, sizeof(int) * n);
+    routePrefix(planner, order, prefix);
+    return 1;
+}
+
+// Local search: move runs of up to MAX_SEGMENT stops (or-opt) and reverse
+// sub-routes (2-opt), taking every improvement found, until a pass finds none.
+// Candidates only re-time the stops from their first change on.
+static double improveRoute(const Planner *planner, int *order) {
+    int n = planner->n;
+    int candidate[ITINERARY_MAX_STOPS];
+    double prefix[ITINERARY_MAX_STOPS + 1];
+    routePrefix(planner, order, prefix);
+    int improved = 1;
+    while (improved) {
+        improved = 0;
+        for (int length = 1; length <= MAX_SEGMENT; length++) {
+            for (int from = 0; from + length <= n; from++) {
+                for (int to = 0; to + length <= n; to++) {
+                    if (to == from)
+                        continue;
+                    // Remove order[from, from + length) and reinsert it at to.
+                    int rest = 0;
+                    for (int i = 0; i < n; i++) {
+                        if (i < from || i >= from + length) {
+                            if (rest == to)
+                                rest += length;
+                            candidate[rest++] = order[i];
+                        }
+                    }
+                    memcpy(candidate + to, order + from, sizeof(int) * length);
+                    improved |= acceptCandidate(planner, order, candidate, to < from ? to : from, prefix);
+                }
+            }
+        }
+        for (int i = 0; i < n - 1; i++) {
+            for (int j = i + 1; j < n; j++) {
+                memcpy(candidate, order, sizeof(int) * n);
+                for (int a = i, b = j; a < b; a++, b--) {
+                    int swap = candidate[a];
+                    candidate[a] = candidate[b];
+                    candidate[b] = swap;
+                }
+                improved |= acceptCandidate(planner, order, candidate, i, prefix);
+            }
+        }
+    }
+    return prefix[n];
+}
+
+// Slides a window of WINDOW stops along the route and reorders each one
+// exactly, keeping the stops before and after it fixed.
+static double improveWindows(const Planner *planner, int *order) {
+    int n = planner->n;
+    double best = followRoute(planner, 0, planner->startTime, order, n);
+    int improved = 1;
+    while (improved) {
+        improved = 0;
+        for (int i = 0; i < n; i += WINDOW_STEP) {
+            int count = n - i < WINDOW ? n - i : WINDOW;
+            double time = followRoute(planner, 0, planner->startTime, order, i);
+            double finish = solveWindow(planner, i > 0 ? order[i - 1] : 0, time, order + i, count,
+                                        order + i + count, n - i - count);
+            if (finish < 0.0)
+                return best;
+            if (finish < best - IMPROVEMENT) {
+                best = finish;
+                improved = 1;
+            }
+            if (i + count == n)
+                break;
+        }
+    }
+    return best;
+}
+
+static void runRestarts(void *context, int begin, int end) {
+    RestartJob *job = context;
+    const Planner *planner = job->planner;
+    for (int r = begin; r < end; r++) {
+        int *order = job->orders + (size_t)r * planner->n;
+        buildGreedy(planner, r, order);
+        double arrival = improveRoute(planner, order);
+        while (improveWindows(planner, order) < arrival - IMPROVEMENT)
+            arrival = improveRoute(planner, order);
+        job->arrivals[r] = arrival;
+    }
+}
+
+// Depth-first branch and bound. A stop still to visit costs at least the
+// shortest flight into it, so arrival + remaining bounds every completion.
+typedef struct {
+    const Planner *planner;
+    int path[ITINERARY_MAX_STOPS];
+    int best[ITINERARY_MAX_STOPS];
+    double bestArrival;
+    long nodes, nodeLimit;
+} Search;
+
+static void branch(Search *search, int depth, int at, double time, uint64_t visited, double remaining) {
+    const Planner *planner = search->planner;
+    int n = planner->n;
+    if (depth == n) {
+        if (time < search->bestArrival - IMPROVEMENT) {
+            search->bestArrival = time;
+            memcpy(search->best, search->path, sizeof(int) * n);
+        }
+        return;
+    }
+    if (++search->nodes > search->nodeLimit)
+        return;
+
+    // Try the earliest arrivals first so good incumbents come early.
+    int next[ITINERARY_MAX_STOPS];
+    double arrival[ITINERARY_MAX_STOPS];
+    int count = 0;
+    for (int k = 1; k <= n; k++) {
+        if (visited & ((uint64_t)1 << (k - 1)))
+            continue;
+        double t = plannerArrival(planner, at, k, time);
+        int slot = count++;
+        while (slot > 0 && arrival[slot - 1] > t) {
+            next[slot] = next[slot - 1];
+            arrival[slot] = arrival[slot - 1];
+            slot--;
+        }
+        next[slot] = k;
+        arrival[slot] = t;
+    }
+    for (int i = 0; i < count && search->nodes <= search->nodeLimit; i++) {
+        int k = next[i];
+        double left = remaining - planner->minFlight[k];
+        if (arrival[i] + left >= search->bestArrival - IMPROVEMENT)
+            continue;
+        search->path[depth] = k;
+        branch(search, depth + 1, k, arrival[i], visited | ((uint64_t)1 << (k - 1)), left);
+    }
+}
+
+static int solveLarge(const Planner *planner, int threads, long nodeLimit, int *order) {
+    int n = planner->n;
+    RestartJob job;
+    job.planner = planner;
+    job.orders = malloc(sizeof(int) * RESTARTS * n);
+    job.arrivals = malloc(sizeof(double) * RESTARTS);
+    if (job.orders == NULL || job.arrivals == NULL) {
+        free(job.orders);
+        free(job.arrivals);
+        return -1;
+    }
+    parallelFor(RESTARTS, 1, threads, runRestarts, &job);
+
+    Search search;
+    search.planner = planner;
+    search.bestArrival = INFINITY;
+    for (int r = 0; r < RESTARTS; r++) {
+        if (job.arrivals[r] < search.bestArrival) {
+            search.bestArrival = job.arrivals[r];
+            memcpy(search.best, job.orders + (size_t)r * n, sizeof(int) * n);
+        }
+    }
+    free(job.orders);
+    free(job.arrivals);
+
+    double remaining = 0.0;
+    for (int k = 1; k <= n; k++)
+        remaining += planner->minFlight[k];
+    search.nodes = 0;
+    search.nodeLimit = nodeLimit;
+    branch(&search, 0, 0, planner->startTime, 0, remaining);
+    memcpy(order, search.best, sizeof(int) * n);
+    return search.nodes <= nodeLimit;
+}
+
+int planItinerary(int start, const int *targets, int count, double startTime,
+                  const ItineraryOptions *options, Itinerary *itinerary) {
+    Planner planner;
+    if (start < 0 || start >= knownDestinationsCount || count < 0 || !isfinite(startTime))
+        return -1;
+    planner.n = 0;
+    planner.bodies[0] = start;
+    planner.startTime = startTime;
+    for (int i = 0; i < count; i++) {
+        int body = targets[i], seen = 0;
+        if (body < 0 || body >= knownDestinationsCount)
+            return -1;
+        for (int j = 0; j <= planner.n && !seen; j++)
+            seen = planner.bodies[j] == body;
+        if (seen)
+            continue;
+        if (planner.n == ITINERARY_MAX_STOPS)
+            return -1;
+        planner.bodies[++planner.n] = body;
+    }
+    for (int j = 0; j <= planner.n; j++) {
+        if (!(knownDestinations[planner.bodies[j]].orbitalPeriod > 0.0))
+            return -1;
+    }
+
+    int n = planner.n;
+    planner.legs = malloc(sizeof(LegModel) * (n + 1) * (n + 1));
+    planner.minFlight = malloc(sizeof(double) * (n + 1));
+    if (planner.legs == NULL || planner.minFlight == NULL) {
+        free(planner.legs);
+        free(planner.minFlight);
+        return -1;
+    }
+    for (int k = 0; k <= n; k++) {
+        planner.minFlight[k] = INFINITY;
+        for (int j = 0; j <= n; j++) {
+            LegModel *leg = &planner.legs[j * (n + 1) + k];
+            legModelInit(leg, &knownDestinations[planner.bodies[j]], &knownDestinations[planner.bodies[k]]);
+            if (j != k && leg->flightTime < planner.minFlight[k])
+                planner.minFlight[k] = leg->flightTime;
+        }
+    }
+
+    int order[ITINERARY_MAX_STOPS];
+    int result;
+    if (n == 0) {
+        result = 1;
+    } else if (n <= ITINERARY_EXACT_LIMIT) {
+        for (int i = 0; i < n; i++)
+            order[i] = i + 1;
+        result = solveWindow(&planner, 0, startTime, order, n, NULL, 0) < 0.0 ? -1 : 1;
+    } else {
+        int threads = options ? options->threads : 0;
+        long nodeLimit = options && options->nodeLimit > 0 ? options->nodeLimit : DEFAULT_NODE_LIMIT;
+        result = solveLarge(&planner, threads, nodeLimit, order);
+    }
+
+    if (result >= 0) {
+        double time = startTime;
+        int at = 0;
+        itinerary->count = n;
+        for (int i = 0; i < n; i++) {
+            ItineraryLeg *leg = &itinerary->legs[i];
+            leg->body = planner.bodies[order[i]];
+            leg->arrivalTime = legArrival(&planner.legs[at * (n + 1) + order[i]], time, &leg->departureTime);
+            time = leg->arrivalTime;
+            at = order[i];
+        }
+        itinerary->arrivalTime = time;
+        itinerary->optimal = result;
+    }
+    free(planner.legs);
+    free(planner.minFlight);
+    return result < 0 ? -1 : 0;
+}
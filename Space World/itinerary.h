@@ -0,0 +1,47 @@
+#ifndef ITINERARY_H
+#define ITINERARY_H
+
+#include "planet.h"
+
+// Most bodies one itinerary can visit (after the start body).
+#define ITINERARY_MAX_STOPS 64
+
+// Sets up to this size are solved exactly by dynamic programming over subsets.
+#define ITINERARY_EXACT_LIMIT 16
+
+typedef struct {
+    int body;              // index into knownDestinations
+    double departureTime;  // leaves the previous body, in days
+    double arrivalTime;    // days
+} ItineraryLeg;
+
+typedef struct {
+    int count;       // legs, one per distinct body visited
+    ItineraryLeg legs[ITINERARY_MAX_STOPS];
+    double arrivalTime;  // end of the last leg (the start time if there are no legs)
+    int optimal;     // 1 if no visiting order arrives earlier
+} Itinerary;
+
+typedef struct {
+    int threads;     // heuristic restarts run on this many threads (<= 0: every CPU)
+    long nodeLimit;  // branch-and-bound nodes for large sets (<= 0: default)
+} ItineraryOptions;
+
+// Earliest arrival at target for a ship at source that is ready at time:
+// a Hohmann transfer leaving at the next launch window, or a phasing
+// manoeuvre between bodies on the same orbit, started at once or when the
+// bodies line up, whichever arrives first. A later time never gives an
+// earlier arrival. Stores the departure time.
+double itineraryLegArrival(const Planet *source, const Planet *target, double time, double *departure);
+
+// Plans the visiting order and departures that reach every body in targets
+// (indices into knownDestinations, duplicates and the start body ignored)
+// as early as possible, leaving start at startTime. Sets up to
+// ITINERARY_EXACT_LIMIT bodies are solved exactly; larger ones take the best
+// of parallel multi-start local search (move, reverse and exact reordering of
+// short windows), refined by a bounded branch and bound.
+// options may be NULL. Returns 0, or -1 if an index or the set size is invalid.
+int planItinerary(int start, const int *targets, int count, double startTime,
+                  const ItineraryOptions *options, Itinerary *itinerary);
+
+#endif
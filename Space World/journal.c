@@ -0,0 +1,292 @@
+#include "journal.h"
+#include "destinations.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t catalogHash(void) {
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < knownDestinationsCount; i++) {
+        const char *name = knownDestinations[i].name;
+        do {
+            hash = (hash ^ (unsigned char)*name) * 1099511628211ull;
+        } while (*name++ != '\0');
+    }
+    return hash;
+}
+
+// Converts to journal units. Returns -1 if the value cannot be represented.
+static int quantize(double value, int bits, int64_t *units) {
+    double scaled = ldexp(value, bits);
+    if (!(fabs(scaled) < 9.0e18))
+        return -1;
+    *units = llround(scaled);
+    return 0;
+}
+
+static int fitsDelta(int64_t delta) {
+    return delta >= INT32_MIN && delta <= INT32_MAX;
+}
+
+// Index of the last snapshot record at or before record, or -1 if there is none.
+static int64_t snapshotAtOrBefore(const JournalReader *reader, uint64_t record) {
+    int64_t k = (int64_t)record;
+    while (k >= 0 && reader->records[k].type != JOURNAL_SNAPSHOT)
+        k--;
+    return k;
+}
+
+static JournalEntry decodeEntry(const int64_t state[4], int destination) {
+    JournalEntry entry;
+    entry.time = ldexp((double)state[0], -JOURNAL_TIME_BITS);
+    entry.position.x = ldexp((double)state[1], -JOURNAL_POSITION_BITS);
+    entry.position.y = ldexp((double)state[2], -JOURNAL_POSITION_BITS);
+    entry.position.z = ldexp((double)state[3], -JOURNAL_POSITION_BITS);
+    entry.destination = destination;
+    return entry;
+}
+
+static int64_t snapshotTime(const JournalReader *reader, int64_t record) {
+    return reader->records[record].u.snapshot.time;
+}
+
+int journalOpen(const char *path, JournalReader *reader) {
+    memset(reader, 0, sizeof(*reader));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(JournalHeader)) {
+        fprintf(stderr, "%s: not a journal\n", path);
+        close(fd);
+        return -1;
+    }
+    void *base = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    const JournalHeader *header = base;
+    if (memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != JOURNAL_VERSION || header->byteOrder != JOURNAL_BYTE_ORDER ||
+        header->recordSize != sizeof(JournalRecord) || header->bodyCount < 0) {
+        fprintf(stderr, "%s: invalid or incompatible journal\n", path);
+        munmap(base, (size_t)info.st_size);
+        return -1;
+    }
+
+    reader->base = base;
+    reader->size = (size_t)info.st_size;
+    reader->header = header;
+    reader->records = (const JournalRecord *)((const char *)base + sizeof(JournalHeader));
+    reader->recordCount = (reader->size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    // A write interrupted between the two halves of a snapshot leaves half of one.
+    if (reader->recordCount > 0 && reader->records[reader->recordCount - 1].type == JOURNAL_SNAPSHOT)
+        reader->recordCount--;
+    return 0;
+}
+
+void journalClose(JournalReader *reader) {
+    if (reader->base != NULL)
+        munmap(reader->base, reader->size);
+    memset(reader, 0, sizeof(*reader));
+}
+
+int journalMatchesCatalog(const JournalReader *reader) {
+    return reader->header->bodyCount == knownDestinationsCount &&
+           reader->header->catalogHash == catalogHash();
+}
+
+void journalRewind(JournalCursor *cursor) {
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->entry.destination = -1;
+}
+
+int journalNext(const JournalReader *reader, JournalCursor *cursor) {
+    if (cursor->next >= reader->recordCount)
+        return 0;
+    const JournalRecord *record = &reader->records[cursor->next];
+    if (record->destination < -1 || record->destination >= reader->header->bodyCount)
+        return -1;
+    if (record->type == JOURNAL_DELTA && cursor->next > 0) {
+        cursor->state[0] += record->u.delta.time;
+        cursor->state[1] += record->u.delta.x;
+        cursor->state[2] += record->u.delta.y;
+        cursor->state[3] += record->u.delta.z;
+        cursor->next += 1;
+    } else if (record->type == JOURNAL_SNAPSHOT && cursor->next + 1 < reader->recordCount &&
+               record[1].type == JOURNAL_SNAPSHOT_TAIL) {
+        cursor->state[0] = record->u.snapshot.time;
+        cursor->state[1] = record->u.snapshot.x;
+        cursor->state[2] = record[1].u.tail.y;
+        cursor->state[3] = record[1].u.tail.z;
+        cursor->next += 2;
+    } else {
+        return -1;
+    }
+    cursor->entry = decodeEntry(cursor->state, record->destination);
+    return 1;
+}
+
+int journalSeek(const JournalReader *reader, double time, JournalCursor *cursor) {
+    journalRewind(cursor);
+    int64_t target;
+    if (reader->recordCount == 0)
+        return 0;
+    if (reader->records[0].type != JOURNAL_SNAPSHOT)
+        return -1;
+    if (quantize(time, JOURNAL_TIME_BITS, &target) != 0)
+        target = time < 0.0 ? INT64_MIN : INT64_MAX;
+    if (snapshotTime(reader, 0) > target)
+        return 0;
+
+    // Last snapshot at or before time. Records before lo are settled; any
+    // snapshot in [lo, hi) may still be later than best.
+    int64_t best = 0;
+    uint64_t lo = 1, hi = reader->recordCount;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        int64_t snapshot = snapshotAtOrBefore(reader, mid);
+        if (snapshot < (int64_t)lo) {
+            lo = mid + 1;
+        } else if (snapshotTime(reader, snapshot) <= target) {
+            best = snapshot;
+            lo = mid + 1;
+        } else {
+            hi = (uint64_t)snapshot;
+        }
+    }
+
+    // Then decode forward while the entries stay at or before time.
+    cursor->next = (uint64_t)best;
+    int status = journalNext(reader, cursor);
+    while (status == 1) {
+        JournalCursor ahead = *cursor;
+        int next = journalNext(reader, &ahead);
+        if (next < 0)
+            return -1;
+        if (next == 0 || ahead.state[0] > target)
+            break;
+        *cursor = ahead;
+    }
+    return status;
+}
+
+int journalOpenWriter(const char *path, JournalWriter *writer) {
+    memset(writer, 0, sizeof(*writer));
+    writer->sinceSnapshot = -1;
+    struct stat info;
+    if (stat(path, &info) != 0 || info.st_size == 0) {
+        JournalHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.byteOrder = JOURNAL_BYTE_ORDER;
+        header.recordSize = sizeof(JournalRecord);
+        header.bodyCount = knownDestinationsCount;
+        header.catalogHash = catalogHash();
+        writer->file = fopen(path, "wb");
+        if (writer->file == NULL) {
+            perror(path);
+            return -1;
+        }
+        if (fwrite(&header, sizeof(header), 1, writer->file) != 1 || fflush(writer->file) != 0) {
+            perror(path);
+            journalCloseWriter(writer);
+            return -1;
+        }
+        return 0;
+    }
+
+    // Resume from the last entry of the existing journal.
+    JournalReader reader;
+    if (journalOpen(path, &reader) != 0)
+        return -1;
+    if (!journalMatchesCatalog(&reader)) {
+        fprintf(stderr, "%s: journal was written for a different destination catalog\n", path);
+        journalClose(&reader);
+        return -1;
+    }
+    int status = 0;
+    if (reader.recordCount > 0) {
+        JournalCursor cursor;
+        journalRewind(&cursor);
+        int64_t snapshot = snapshotAtOrBefore(&reader, reader.recordCount - 1);
+        cursor.next = snapshot < 0 ? reader.recordCount : (uint64_t)snapshot;
+        while ((status = journalNext(&reader, &cursor)) == 1)
+            writer->sinceSnapshot++;
+        memcpy(writer->last, cursor.state, sizeof(writer->last));
+        writer->lastDestination = cursor.entry.destination;
+        if (snapshot < 0)
+            status = -1;
+    }
+    off_t length = (off_t)(sizeof(JournalHeader) + reader.recordCount * sizeof(JournalRecord));
+    journalClose(&reader);
+    if (status != 0) {
+        fprintf(stderr, "%s: corrupt journal\n", path);
+        return -1;
+    }
+    // Drop any torn record so appends stay aligned.
+    if (truncate(path, length) != 0 || (writer->file = fopen(path, "ab")) == NULL) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int journalLastEntry(const JournalWriter *writer, JournalEntry *entry) {
+    if (writer->sinceSnapshot < 0)
+        return 0;
+    *entry = decodeEntry(writer->last, writer->lastDestination);
+    return 1;
+}
+
+int journalAppend(JournalWriter *writer, const ShipState *state) {
+    int64_t now[4];
+    if (quantize(state->currentTime, JOURNAL_TIME_BITS, &now[0]) != 0 ||
+        quantize(state->shipPosition.x, JOURNAL_POSITION_BITS, &now[1]) != 0 ||
+        quantize(state->shipPosition.y, JOURNAL_POSITION_BITS, &now[2]) != 0 ||
+        quantize(state->shipPosition.z, JOURNAL_POSITION_BITS, &now[3]) != 0)
+        return -1;
+
+    JournalRecord records[2];
+    memset(records, 0, sizeof(records));
+    records[0].destination = records[1].destination = state->currentDestination.index;
+    int snapshot = writer->sinceSnapshot < 0 || writer->sinceSnapshot >= JOURNAL_SNAPSHOT_INTERVAL - 1;
+    for (int k = 0; k < 4 && !snapshot; k++)
+        snapshot = !fitsDelta(now[k] - writer->last[k]);
+    if (snapshot) {
+        records[0].type = JOURNAL_SNAPSHOT;
+        records[0].u.snapshot.time = now[0];
+        records[0].u.snapshot.x = now[1];
+        records[1].type = JOURNAL_SNAPSHOT_TAIL;
+        records[1].u.tail.y = now[2];
+        records[1].u.tail.z = now[3];
+    } else {
+        records[0].type = JOURNAL_DELTA;
+        records[0].u.delta.time = (int32_t)(now[0] - writer->last[0]);
+        records[0].u.delta.x = (int32_t)(now[1] - writer->last[1]);
+        records[0].u.delta.y = (int32_t)(now[2] - writer->last[2]);
+        records[0].u.delta.z = (int32_t)(now[3] - writer->last[3]);
+    }
+    size_t count = snapshot ? 2 : 1;
+    if (fwrite(records, sizeof(JournalRecord), count, writer->file) != count || fflush(writer->file) != 0)
+        return -1;
+    memcpy(writer->last, now, sizeof(now));
+    writer->lastDestination = records[0].destination;
+    writer->sinceSnapshot = snapshot ? 0 : writer->sinceSnapshot + 1;
+    return 0;
+}
+
+void journalCloseWriter(JournalWriter *writer) {
+    if (writer->file != NULL)
+        fclose(writer->file);
+    writer->file = NULL;
+}
@@ -0,0 +1,118 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "spacenav.h"
+
+#define JOURNAL_MAGIC "SPNJRNL1"
+#define JOURNAL_VERSION 1
+#define JOURNAL_BYTE_ORDER 0x01020304u
+
+// Positions are journaled in units of 2^-JOURNAL_POSITION_BITS AU (about
+// 140 m) and times in units of 2^-JOURNAL_TIME_BITS days (about 0.08 s).
+// Sums of deltas are exact in these units, so replay never drifts.
+#define JOURNAL_POSITION_BITS 30
+#define JOURNAL_TIME_BITS 20
+
+// A full snapshot is written at least every this many entries, so a seek
+// decodes at most this many deltas.
+#define JOURNAL_SNAPSHOT_INTERVAL 64
+
+enum {
+    JOURNAL_DELTA = 1,          // one record: changes since the previous entry
+    JOURNAL_SNAPSHOT = 2,       // first record of a full state
+    JOURNAL_SNAPSHOT_TAIL = 3   // second record of a full state
+};
+
+// The file is this header followed by fixed-size records. An entry is a
+// delta record, or a snapshot record pair when the change does not fit a
+// delta or a snapshot is due. Every record starts with its type, so any
+// record can be classified without decoding from the start.
+typedef struct {
+    char magic[8];           // JOURNAL_MAGIC, not NUL-terminated
+    uint32_t version;        // JOURNAL_VERSION
+    uint32_t byteOrder;      // JOURNAL_BYTE_ORDER as written by the producer
+    uint32_t recordSize;     // sizeof(JournalRecord)
+    int32_t bodyCount;       // catalog the destination indices refer to
+    uint64_t catalogHash;    // FNV-1a over the catalog's names
+} JournalHeader;
+
+typedef struct {
+    uint8_t type;
+    uint8_t reserved[3];
+    int32_t destination;     // catalog index, -1 if no known destination
+    union {
+        struct { int32_t time, x, y, z; } delta;   // change in journal units
+        struct { int64_t time, x; } snapshot;      // absolute, journal units
+        struct { int64_t y, z; } tail;
+    } u;
+} JournalRecord;
+
+// One decoded entry: the ship's state after a transition.
+typedef struct {
+    double time;
+    Vector3D position;
+    int destination;         // catalog index, -1 if none
+} JournalEntry;
+
+typedef struct JournalWriter {
+    FILE *file;
+    int64_t last[4];         // time, x, y, z of the last entry, in journal units
+    int lastDestination;
+    int sinceSnapshot;       // entries since the last snapshot; -1 before the first
+} JournalWriter;
+
+// A read-only mapped journal.
+typedef struct {
+    void *base;
+    size_t size;
+    const JournalHeader *header;
+    const JournalRecord *records;
+    uint64_t recordCount;    // complete records; a torn final snapshot is dropped
+} JournalReader;
+
+// Position in a journal: the entry last decoded and where the next starts.
+typedef struct {
+    uint64_t next;           // record index
+    int64_t state[4];        // time, x, y, z in journal units
+    JournalEntry entry;
+} JournalCursor;
+
+// Opens a journal for appending, creating it if needed. An existing journal
+// must have been written for the current catalog; a torn final record from
+// an interrupted write is discarded. Returns 0, or -1 on error.
+int journalOpenWriter(const char *path, JournalWriter *writer);
+
+// The last entry of the journal, so a mission can resume where it stopped.
+// Returns 1, or 0 if the journal is empty.
+int journalLastEntry(const JournalWriter *writer, JournalEntry *entry);
+
+// Appends the ship's state and flushes it to the file. Returns 0, or -1 on error.
+int journalAppend(JournalWriter *writer, const ShipState *state);
+
+void journalCloseWriter(JournalWriter *writer);
+
+// Maps a journal read-only and validates its header. Returns 0, or -1 on error.
+int journalOpen(const char *path, JournalReader *reader);
+
+void journalClose(JournalReader *reader);
+
+// 1 if the journal was written for the current catalog.
+int journalMatchesCatalog(const JournalReader *reader);
+
+// Places the cursor before the first entry.
+void journalRewind(JournalCursor *cursor);
+
+// Decodes the entry at the cursor into cursor->entry and advances.
+// Returns 1, 0 at the end of the journal, or -1 if the journal is corrupt.
+int journalNext(const JournalReader *reader, JournalCursor *cursor);
+
+// Places the cursor on the last entry at or before time: binary search over
+// the snapshots, then at most JOURNAL_SNAPSHOT_INTERVAL deltas. Assumes
+// mission time never decreases along the journal (no negative travel).
+// Returns 1, 0 if the journal starts after time, or -1 if it is corrupt.
+int journalSeek(const JournalReader *reader, double time, JournalCursor *cursor);
+
+#endif
@@ -0,0 +1,178 @@
+#include "kepler.h"
+#include "ephemeris.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEPLER_BLOCK 256
+
+// Solves Kepler's equation for count <= KEPLER_BLOCK mean anomalies m (turns).
+// The starter E0 = M + e sin M / sqrt(1 - 2e cos M + e^2) is within a few
+// percent even near periapsis of very eccentric orbits, so a fixed number of
+// Halley steps converges everywhere. Each pass is a short branch-free loop
+// over the block that the compiler can vectorize (the starter's sqrt only
+// with -fno-math-errno). The last step is folded into sin/cos by a
+// second-order update instead of another evaluation.
+static void solveKeplerBlock(const double *m, const double *e, int count, double *sinE, double *cosE) {
+    double meanAnomaly[KEPLER_BLOCK], E[KEPLER_BLOCK], step[KEPLER_BLOCK];
+    for (int i = 0; i < count; i++) {
+        double turns = m[i] - roundNearest(m[i]);
+        double s, c;
+        sinCosKernel(turns, &s, &c);
+        meanAnomaly[i] = turns * TWO_PI;
+        E[i] = meanAnomaly[i] + e[i] * s / sqrt(1.0 - 2.0 * e[i] * c + e[i] * e[i]);
+    }
+    for (int k = 0; k < KEPLER_ITERATIONS; k++) {
+        for (int i = 0; i < count; i++) {
+            double s, c;
+            sinCosKernel(E[i] * (1.0 / TWO_PI), &s, &c);
+            double f = E[i] - e[i] * s - meanAnomaly[i];
+            double slope = 1.0 - e[i] * c;
+            step[i] = -f / (slope - 0.5 * f * e[i] * s / slope);
+            E[i] += step[i];
+            sinE[i] = s;
+            cosE[i] = c;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        double s = sinE[i], c = cosE[i], halfSquare = 0.5 * step[i] * step[i];
+        sinE[i] = s + c * step[i] - s * halfSquare;
+        cosE[i] = c - s * step[i] - c * halfSquare;
+    }
+}
+
+void keplerSetInit(KeplerSet *set) {
+    memset(set, 0, sizeof(*set));
+}
+
+void keplerSetFree(KeplerSet *set) {
+    free(set->eccentricity);
+    free(set->meanAnomaly);
+    free(set->px);
+    free(set->py);
+    free(set->pz);
+    free(set->qx);
+    free(set->qy);
+    free(set->qz);
+    keplerSetInit(set);
+}
+
+static int keplerSetGrow(KeplerSet *set) {
+    int capacity = set->capacity ? 2 * set->capacity : 64;
+    double **arrays[] = { &set->eccentricity, &set->meanAnomaly, &set->px, &set->py, &set->pz,
+                          &set->qx, &set->qy, &set->qz };
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        double *grown = realloc(*arrays[a], sizeof(double) * capacity);
+        if (grown == NULL)
+            return -1;
+        *arrays[a] = grown;
+    }
+    set->capacity = capacity;
+    return 0;
+}
+
+// One orbit's eccentricity, mean anomaly at time 0 (turns) and p, q axes.
+typedef struct {
+    double e, m;
+    double p[3], q[3];
+} OrbitAxes;
+
+static OrbitAxes orbitAxes(const OrbitalElements *elements) {
+    OrbitAxes axes;
+    double a = elements->semiMajorAxis, e = elements->eccentricity;
+    double b = a * sqrt(1.0 - e * e);
+    double ci = cos(elements->inclination), si = sin(elements->inclination);
+    double cn = cos(elements->ascendingNode), sn = sin(elements->ascendingNode);
+    double cw = cos(elements->argumentOfPeriapsis), sw = sin(elements->argumentOfPeriapsis);
+    axes.e = e;
+    axes.m = elements->meanAnomaly / TWO_PI;
+    axes.p[0] = a * (cw * cn - sw * sn * ci);
+    axes.p[1] = a * (cw * sn + sw * cn * ci);
+    axes.p[2] = a * (sw * si);
+    axes.q[0] = b * (-sw * cn - cw * sn * ci);
+    axes.q[1] = b * (-sw * sn + cw * cn * ci);
+    axes.q[2] = b * (cw * si);
+    return axes;
+}
+
+int keplerSetAdd(KeplerSet *set, const OrbitalElements *elements) {
+    if (set->count == set->capacity && keplerSetGrow(set) != 0)
+        return -1;
+    int i = set->count++;
+    OrbitAxes axes = orbitAxes(elements);
+    set->eccentricity[i] = axes.e;
+    set->meanAnomaly[i] = axes.m;
+    set->px[i] = axes.p[0];
+    set->py[i] = axes.p[1];
+    set->pz[i] = axes.p[2];
+    set->qx[i] = axes.q[0];
+    set->qy[i] = axes.q[1];
+    set->qz[i] = axes.q[2];
+    return i;
+}
+
+KeplerOrbits keplerSetOrbits(const KeplerSet *set) {
+    KeplerOrbits orbits = { set->eccentricity, set->meanAnomaly, set->px, set->py, set->pz,
+                            set->qx, set->qy, set->qz };
+    return orbits;
+}
+
+KeplerOrbits keplerOrbitsSlice(KeplerOrbits orbits, int first) {
+    KeplerOrbits slice = { orbits.eccentricity + first, orbits.meanAnomaly + first,
+                           orbits.px + first, orbits.py + first, orbits.pz + first,
+                           orbits.qx + first, orbits.qy + first, orbits.qz + first };
+    return slice;
+}
+
+void solveKeplerBatch(const double *meanAnomaly, const double *eccentricity, int count,
+                      double *sinE, double *cosE) {
+    for (int first = 0; first < count; first += KEPLER_BLOCK) {
+        int block = count - first < KEPLER_BLOCK ? count - first : KEPLER_BLOCK;
+        solveKeplerBlock(meanAnomaly + first, eccentricity + first, block, sinE + first, cosE + first);
+    }
+}
+
+void keplerPositions(KeplerOrbits orbits, const double *period, int count, double time,
+                     double *restrict x, double *restrict y, double *restrict z) {
+    double m[KEPLER_BLOCK], s[KEPLER_BLOCK], c[KEPLER_BLOCK];
+    for (int first = 0; first < count; first += KEPLER_BLOCK) {
+        int block = count - first < KEPLER_BLOCK ? count - first : KEPLER_BLOCK;
+        for (int i = 0; i < block; i++)
+            m[i] = orbits.meanAnomaly[first + i] + time / period[first + i];
+        solveKeplerBlock(m, orbits.eccentricity + first, block, s, c);
+        for (int i = 0; i < block; i++) {
+            int b = first + i;
+            double u = c[i] - orbits.eccentricity[b];
+            x[b] = orbits.px[b] * u + orbits.qx[b] * s[i];
+            y[b] = orbits.py[b] * u + orbits.qy[b] * s[i];
+            z[b] = orbits.pz[b] * u + orbits.qz[b] * s[i];
+        }
+    }
+}
+
+Vector3D keplerOrbitPosition(KeplerOrbits orbits, int i, double period, double time, Vector3D *velocity) {
+    double e = orbits.eccentricity[i];
+    double m = orbits.meanAnomaly[i] + time / period, s, c;
+    solveKeplerBlock(&m, &e, 1, &s, &c);
+    double u = c - e;
+    if (velocity != NULL) {
+        // dE/dt = n / (1 - e cos E), with n the mean motion in radians per day.
+        double rate = TWO_PI / (period * (1.0 - e * c));
+        velocity->x = (-orbits.px[i] * s + orbits.qx[i] * c) * rate;
+        velocity->y = (-orbits.py[i] * s + orbits.qy[i] * c) * rate;
+        velocity->z = (-orbits.pz[i] * s + orbits.qz[i] * c) * rate;
+    }
+    Vector3D pos = { orbits.px[i] * u + orbits.qx[i] * s, orbits.py[i] * u + orbits.qy[i] * s,
+                     orbits.pz[i] * u + orbits.qz[i] * s };
+    return pos;
+}
+
+Vector3D keplerPosition(const OrbitalElements *elements, double time) {
+    OrbitAxes axes = orbitAxes(elements);
+    double m = axes.m + time / elements->period, s, c;
+    solveKeplerBlock(&m, &axes.e, 1, &s, &c);
+    double u = c - axes.e;
+    Vector3D pos = { axes.p[0] * u + axes.q[0] * s, axes.p[1] * u + axes.q[1] * s,
+                     axes.p[2] * u + axes.q[2] * s };
+    return pos;
+}
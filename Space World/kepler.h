@@ -0,0 +1,68 @@
+#ifndef KEPLER_H
+#define KEPLER_H
+
+#include "planet.h"
+
+// Halley steps per solve. Every body runs the same count so batch loops stay
+// branch-free; from the starter used, 4 steps leave |E - e sin E - M| below
+// 1e-15 for e <= 0.995 and below 2e-10 for e <= 0.999 (worst just past
+// periapsis, where the starter is furthest off).
+#define KEPLER_ITERATIONS 4
+
+// Classical orbital elements. Angles are in radians; the reference plane is
+// the one the circular orbits lie in (z = 0).
+typedef struct {
+    double semiMajorAxis;        // AU
+    double period;               // days
+    double eccentricity;         // 0 <= e < 1
+    double inclination;
+    double ascendingNode;        // longitude of the ascending node
+    double argumentOfPeriapsis;
+    double meanAnomaly;          // at time 0
+} OrbitalElements;
+
+// Precomputed orbits in structure-of-arrays form. At eccentric anomaly E a
+// body sits at p * (cos E - e) + q * sin E, where p is the periapsis direction
+// scaled by the semi-major axis and q the in-plane normal to it scaled by the
+// semi-minor axis; together they are the body's rotation matrix.
+typedef struct {
+    const double *eccentricity;
+    const double *meanAnomaly;   // at time 0, in turns
+    const double *px, *py, *pz;
+    const double *qx, *qy, *qz;
+} KeplerOrbits;
+
+// Owns the arrays behind a KeplerOrbits view.
+typedef struct {
+    int count, capacity;
+    double *eccentricity, *meanAnomaly;
+    double *px, *py, *pz, *qx, *qy, *qz;
+} KeplerSet;
+
+void keplerSetInit(KeplerSet *set);
+void keplerSetFree(KeplerSet *set);
+
+// Precomputes one body. Returns its index, or -1 on allocation failure.
+int keplerSetAdd(KeplerSet *set, const OrbitalElements *elements);
+
+KeplerOrbits keplerSetOrbits(const KeplerSet *set);
+
+// The same orbits starting at body first.
+KeplerOrbits keplerOrbitsSlice(KeplerOrbits orbits, int first);
+
+// Solves E - e sin E = M for count bodies, with M in turns; writes sin E and cos E.
+void solveKeplerBatch(const double *meanAnomaly, const double *eccentricity, int count,
+                      double *sinE, double *cosE);
+
+// Positions (AU) of bodies [0, count) at time, given their periods in days.
+void keplerPositions(KeplerOrbits orbits, const double *period, int count, double time,
+                     double *x, double *y, double *z);
+
+// Position of body i of a precomputed set at time and, if velocity is not
+// NULL, its velocity (AU/day).
+Vector3D keplerOrbitPosition(KeplerOrbits orbits, int i, double period, double time, Vector3D *velocity);
+
+// Position of one body at time.
+Vector3D keplerPosition(const OrbitalElements *elements, double time);
+
+#endif
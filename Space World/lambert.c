@@ -0,0 +1,132 @@
+#include "lambert.h"
+#include <math.h>
+
+#define PI 3.141592653589793
+// Bisection on psi over (-4 PI, 4 PI^2) reaches double precision in this many steps.
+#define LAMBERT_ITERATIONS 56
+// Terms of the Stumpff series; enough for |psi| <= 4 PI^2.
+#define STUMPFF_TERMS 24
+
+// Problems are solved LAMBERT_LANES at a time; every step below is a loop
+// over the lanes of a block, which the compiler turns into SIMD code.
+#define LAMBERT_LANES 8
+
+typedef struct {
+    double r1x[LAMBERT_LANES], r1y[LAMBERT_LANES], r1z[LAMBERT_LANES];
+    double r2x[LAMBERT_LANES], r2y[LAMBERT_LANES], r2z[LAMBERT_LANES];
+    double tof[LAMBERT_LANES];
+    double r1[LAMBERT_LANES], r2[LAMBERT_LANES], a[LAMBERT_LANES];
+    double psi[LAMBERT_LANES], low[LAMBERT_LANES], high[LAMBERT_LANES];
+    double c[LAMBERT_LANES], s[LAMBERT_LANES], y[LAMBERT_LANES], dt[LAMBERT_LANES];
+} LambertBlock;
+
+// Stumpff functions C(psi) and S(psi) from their nested series, valid for
+// elliptic and hyperbolic psi alike, with no branches or libm calls.
+static void stumpffLanes(LambertBlock *b) {
+    double tc[LAMBERT_LANES], ts[LAMBERT_LANES];
+    for (int l = 0; l < LAMBERT_LANES; l++)
+        tc[l] = ts[l] = 1.0;
+    for (int k = STUMPFF_TERMS; k >= 1; k--) {
+        double kc = 1.0 / ((2.0 * k + 1.0) * (2.0 * k + 2.0));
+        double ks = 1.0 / ((2.0 * k + 2.0) * (2.0 * k + 3.0));
+        for (int l = 0; l < LAMBERT_LANES; l++) {
+            tc[l] = 1.0 - b->psi[l] * tc[l] * kc;
+            ts[l] = 1.0 - b->psi[l] * ts[l] * ks;
+        }
+    }
+    for (int l = 0; l < LAMBERT_LANES; l++) {
+        b->c[l] = tc[l] * 0.5;
+        b->s[l] = ts[l] * (1.0 / 6.0);
+    }
+}
+
+// Evaluates y(psi) and the matching time of flight for every lane.
+static void timeOfFlightLanes(LambertBlock *b) {
+    double sqrtMu = sqrt(SUN_GM);
+    stumpffLanes(b);
+    for (int l = 0; l < LAMBERT_LANES; l++) {
+        double y = b->r1[l] + b->r2[l] + b->a[l] * (b->psi[l] * b->s[l] - 1.0) / sqrt(b->c[l]);
+        double yPos = fmax(y, 0.0);
+        double chi = sqrt(yPos / b->c[l]);
+        b->y[l] = y;
+        b->dt[l] = (chi * chi * chi * b->s[l] + b->a[l] * sqrt(yPos)) / sqrtMu;
+    }
+}
+
+// Universal-variable Lambert solver (Vallado) for one block of problems.
+static void solveBlock(LambertBlock *b, int retrograde) {
+    for (int l = 0; l < LAMBERT_LANES; l++) {
+        double r1 = sqrt(b->r1x[l] * b->r1x[l] + b->r1y[l] * b->r1y[l] + b->r1z[l] * b->r1z[l]);
+        double r2 = sqrt(b->r2x[l] * b->r2x[l] + b->r2y[l] * b->r2y[l] + b->r2z[l] * b->r2z[l]);
+        double cosDnu = (b->r1x[l] * b->r2x[l] + b->r1y[l] * b->r2y[l] + b->r1z[l] * b->r2z[l]) / (r1 * r2);
+        double crossZ = b->r1x[l] * b->r2y[l] - b->r1y[l] * b->r2x[l];
+        // Short way (under half a turn) when that direction matches the requested sense.
+        double tm = ((crossZ >= 0.0) != (retrograde != 0)) ? 1.0 : -1.0;
+        b->r1[l] = r1;
+        b->r2[l] = r2;
+        b->a[l] = tm * sqrt(fmax(r1 * r2 * (1.0 + cosDnu), 0.0));
+        b->low[l] = -4.0 * PI;
+        b->high[l] = 4.0 * PI * PI;
+    }
+
+    for (int it = 0; it < LAMBERT_ITERATIONS; it++) {
+        for (int l = 0; l < LAMBERT_LANES; l++)
+            b->psi[l] = 0.5 * (b->low[l] + b->high[l]);
+        timeOfFlightLanes(b);
+        for (int l = 0; l < LAMBERT_LANES; l++) {
+            // A negative y means psi is too small, the same as a flight that is too short.
+            int tooShort = (b->y[l] < 0.0) | (b->dt[l] <= b->tof[l]);
+            b->low[l] = tooShort ? b->psi[l] : b->low[l];
+            b->high[l] = tooShort ? b->high[l] : b->psi[l];
+        }
+    }
+    for (int l = 0; l < LAMBERT_LANES; l++)
+        b->psi[l] = 0.5 * (b->low[l] + b->high[l]);
+    timeOfFlightLanes(b);
+}
+
+void solveLambertBatch(const LambertProblems *problems, LambertSolutions *solutions) {
+    LambertBlock block;
+    for (int base = 0; base < problems->count; base += LAMBERT_LANES) {
+        int lanes = problems->count - base < LAMBERT_LANES ? problems->count - base : LAMBERT_LANES;
+        // Pad a short final block with copies of its first problem.
+        for (int l = 0; l < LAMBERT_LANES; l++) {
+            int i = base + (l < lanes ? l : 0);
+            block.r1x[l] = problems->r1x[i];
+            block.r1y[l] = problems->r1y[i];
+            block.r1z[l] = problems->r1z[i];
+            block.r2x[l] = problems->r2x[i];
+            block.r2y[l] = problems->r2y[i];
+            block.r2z[l] = problems->r2z[i];
+            block.tof[l] = problems->tof[i];
+        }
+        solveBlock(&block, problems->retrograde);
+
+        for (int l = 0; l < lanes; l++) {
+            int i = base + l;
+            double y = fmax(block.y[l], 0.0);
+            double f = 1.0 - y / block.r1[l];
+            double g = block.a[l] * sqrt(y / SUN_GM);
+            double gDot = 1.0 - y / block.r2[l];
+            solutions->v1x[i] = (block.r2x[l] - f * block.r1x[l]) / g;
+            solutions->v1y[i] = (block.r2y[l] - f * block.r1y[l]) / g;
+            solutions->v1z[i] = (block.r2z[l] - f * block.r1z[l]) / g;
+            solutions->v2x[i] = (gDot * block.r2x[l] - block.r1x[l]) / g;
+            solutions->v2y[i] = (gDot * block.r2y[l] - block.r1y[l]) / g;
+            solutions->v2z[i] = (gDot * block.r2z[l] - block.r1z[l]) / g;
+            // Reject degenerate geometry and flights outside the single-revolution range.
+            int solved = block.tof[l] > 0.0 && block.y[l] > 0.0 && block.r1[l] > 0.0 && block.r2[l] > 0.0 &&
+                         fabs(block.a[l]) > 1e-12 * (block.r1[l] + block.r2[l]) &&
+                         fabs(block.dt[l] - block.tof[l]) <= 1e-8 * block.tof[l];
+            solutions->status[i] = solved ? 0 : -1;
+        }
+    }
+}
+
+int solveLambert(Vector3D r1, Vector3D r2, double tof, int retrograde, Vector3D *v1, Vector3D *v2) {
+    LambertProblems problem = { &r1.x, &r1.y, &r1.z, &r2.x, &r2.y, &r2.z, &tof, 1, retrograde };
+    int status;
+    LambertSolutions solution = { &v1->x, &v1->y, &v1->z, &v2->x, &v2->y, &v2->z, &status };
+    solveLambertBatch(&problem, &solution);
+    return status;
+}
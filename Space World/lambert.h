@@ -0,0 +1,35 @@
+#ifndef LAMBERT_H
+#define LAMBERT_H
+
+#include "planet.h"
+
+// Sun's gravitational parameter (Gaussian constant squared), in AU^3/day^2.
+#define SUN_GM 2.959122082855911e-4
+
+// Structure-of-arrays batch of Lambert problems: positions in AU, times in days.
+typedef struct {
+    const double *r1x, *r1y, *r1z;  // departure positions
+    const double *r2x, *r2y, *r2z;  // arrival positions
+    const double *tof;              // times of flight
+    int count;
+    int retrograde;                 // nonzero solves every problem clockwise
+} LambertProblems;
+
+// Transfer velocities in AU/day; status is 0 for a solved problem and -1 if
+// there is no single-revolution solution (or the geometry is degenerate).
+typedef struct {
+    double *v1x, *v1y, *v1z;  // departure velocities
+    double *v2x, *v2y, *v2z;  // arrival velocities
+    int *status;
+} LambertSolutions;
+
+// Solves the single-revolution Lambert problem around the Sun: the orbit that
+// goes from r1 to r2 in tof days, counterclockwise (prograde) unless retrograde.
+// Returns 0 on success, -1 if there is no solution.
+int solveLambert(Vector3D r1, Vector3D r2, double tof, int retrograde, Vector3D *v1, Vector3D *v2);
+
+// Solves every problem of a batch. Problems run in blocks of lanes that all take
+// the same fixed number of bisection steps with no data-dependent branches.
+void solveLambertBatch(const LambertProblems *problems, LambertSolutions *solutions);
+
+#endif
@@ -0,0 +1,126 @@
+#include "launchwindow.h"
+#include "ephemeris.h"
+#include "navigation.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#define PI 3.141592653589793
+#define ROWS_PER_TASK 16
+
+typedef struct {
+    const LaunchWindowGrid *grid;
+    double sourcePeriod, targetPeriod;
+    double hohmannTime, inverseHohmannTime;
+    int tofCount;
+    LaunchWindow *rowBest;  // best time of flight for each departure
+    atomic_int failed;      // a task ran out of memory
+} SweepJob;
+
+// Number of samples from start to end inclusive, or -1 if out of range.
+static long gridCount(double start, double end, double step) {
+    if (!(step > 0.0) || !(end >= start))
+        return -1;
+    double count = floor((end - start) / step + 1e-9) + 1.0;
+    return count > 1e8 ? -1 : (long)count;
+}
+
+// Scores rows [begin, end) of the grid. The inner loop over time of flight is
+// branch-free so the compiler vectorizes it.
+static void sweepRows(void *context, int begin, int end) {
+    SweepJob *job = context;
+    const LaunchWindowGrid *grid = job->grid;
+    int n = job->tofCount;
+    double *phase = malloc(sizeof(double) * n);
+    double *score = malloc(sizeof(double) * n);
+    if (phase == NULL || score == NULL) {
+        atomic_store(&job->failed, 1);
+        free(phase);
+        free(score);
+        return;
+    }
+
+    for (int i = begin; i < end; i++) {
+        double departure = grid->departureStart + i * grid->departureStep;
+        // For a Hohmann arrival the target must sit opposite the departure point.
+        double wantedTurns = departure / job->sourcePeriod + 0.5;
+        for (int j = 0; j < n; j++) {
+            double tof = grid->tofMin + j * grid->tofStep;
+            double miss = (departure + tof) / job->targetPeriod - wantedTurns;
+            miss -= roundNearest(miss);  // [-0.5, 0.5] turns
+            double tofError = (tof - job->hohmannTime) * job->inverseHohmannTime;
+            phase[j] = miss;
+            score[j] = 2.0 * fabs(miss) + fabs(tofError);
+        }
+
+        int best = 0;
+        for (int j = 1; j < n; j++) {
+            if (score[j] < score[best])
+                best = j;
+        }
+        LaunchWindow *window = &job->rowBest[i];
+        window->departureTime = departure;
+        window->timeOfFlight = grid->tofMin + best * grid->tofStep;
+        window->phaseError = phase[best] * 2 * PI;
+        window->tofError = (window->timeOfFlight - job->hohmannTime) * job->inverseHohmannTime;
+        window->score = score[best];
+    }
+    free(phase);
+    free(score);
+}
+
+static int compareWindows(const void *a, const void *b) {
+    double sa = ((const LaunchWindow *)a)->score, sb = ((const LaunchWindow *)b)->score;
+    return (sa > sb) - (sa < sb);
+}
+
+long launchWindowGridCells(const LaunchWindowGrid *grid) {
+    long departures = gridCount(grid->departureStart, grid->departureEnd, grid->departureStep);
+    long tofs = gridCount(grid->tofMin, grid->tofMax, grid->tofStep);
+    return departures < 0 || tofs < 0 ? -1 : departures * tofs;
+}
+
+int findLaunchWindows(const Planet *source, const Planet *target, const LaunchWindowGrid *grid,
+                      LaunchWindow *windows, int maxWindows) {
+    long departures = gridCount(grid->departureStart, grid->departureEnd, grid->departureStep);
+    long tofs = gridCount(grid->tofMin, grid->tofMax, grid->tofStep);
+    if (departures < 0 || tofs < 0 || !(grid->tofMin > 0.0) || departures * tofs > 4e9 ||
+        !(source->orbitalPeriod > 0.0) || !(target->orbitalPeriod > 0.0))
+        return -1;
+
+    SweepJob job;
+    job.grid = grid;
+    job.sourcePeriod = source->orbitalPeriod;
+    job.targetPeriod = target->orbitalPeriod;
+    job.hohmannTime = computeHohmannTransferTime(source->orbitRadius, target->orbitRadius);
+    // Same-orbit transfers are pure phasing, so only the phase error counts.
+    job.inverseHohmannTime = job.hohmannTime > 0.0 ? 1.0 / job.hohmannTime : 0.0;
+    job.tofCount = (int)tofs;
+    job.rowBest = malloc(sizeof(LaunchWindow) * departures);
+    if (job.rowBest == NULL)
+        return -1;
+    atomic_init(&job.failed, 0);
+
+    parallelFor((int)departures, ROWS_PER_TASK, grid->threads, sweepRows, &job);
+    if (atomic_load(&job.failed)) {
+        free(job.rowBest);
+        return -1;
+    }
+
+    // Keep one window per basin: rows that beat their left and match their right neighbour.
+    int found = 0;
+    for (long i = 0; i < departures; i++) {
+        double s = job.rowBest[i].score;
+        if ((i == 0 || s < job.rowBest[i - 1].score) &&
+            (i == departures - 1 || s <= job.rowBest[i + 1].score))
+            job.rowBest[found++] = job.rowBest[i];
+    }
+    qsort(job.rowBest, found, sizeof(LaunchWindow), compareWindows);
+    if (found > maxWindows)
+        found = maxWindows;
+    for (int k = 0; k < found; k++)
+        windows[k] = job.rowBest[k];
+    free(job.rowBest);
+    return found;
+}
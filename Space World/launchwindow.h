@@ -0,0 +1,33 @@
+#ifndef LAUNCHWINDOW_H
+#define LAUNCHWINDOW_H
+
+#include "planet.h"
+
+// Departure-date by time-of-flight grid to sweep. Times are in days;
+// cell (i, j) departs at departureStart + i * departureStep and flies
+// tofMin + j * tofStep, with both ends inclusive.
+typedef struct {
+    double departureStart, departureEnd, departureStep;
+    double tofMin, tofMax, tofStep;
+    int threads;  // <= 0 uses every CPU
+} LaunchWindowGrid;
+
+typedef struct {
+    double departureTime;  // days
+    double timeOfFlight;   // days
+    double phaseError;     // radians; target's miss from the point opposite departure
+    double tofError;       // (timeOfFlight - Hohmann time) / Hohmann time
+    double score;          // |phaseError| / PI + |tofError|, lower is better
+} LaunchWindow;
+
+// Number of cells in grid, or -1 if it is invalid.
+long launchWindowGridCells(const LaunchWindowGrid *grid);
+
+// Scores every grid cell for a transfer from source to target and returns up to
+// maxWindows distinct windows (local minima along the departure axis), best first.
+// Returns the number of windows written, or -1 if the grid is invalid or
+// memory runs out.
+int findLaunchWindows(const Planet *source, const Planet *target, const LaunchWindowGrid *grid,
+                      LaunchWindow *windows, int maxWindows);
+
+#endif
@@ -0,0 +1,200 @@
+// Load generator for the navigation daemon (space_navigator -s SOCKET).
+// Build and run with: ./build.sh loadgen -s SOCKET [-c connections] [-d depth] [-n requests]
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_CONNECTIONS 16
+#define DEFAULT_DEPTH 16        // requests in flight per connection
+#define DEFAULT_REQUESTS 200000
+#define MAX_REQUEST_LINE 128
+
+// One client connection, pipelining up to depth requests.
+typedef struct {
+    int fd;
+    long quota;          // requests this connection sends in total
+    long issued, answered;
+    double *sentAt;      // ring of send times, depth entries
+    char *output;        // requests not yet written
+    size_t outputLength, outputSent;
+    char input[65536];
+    size_t inputLength;
+} LoadConnection;
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void printUsage(const char *program) {
+    printf("Usage: %s -s SOCKET [-c connections] [-d depth] [-n requests]\n", program);
+    printf("  -s SOCKET        daemon socket (space_navigator -s SOCKET)\n");
+    printf("  -c N             concurrent connections (default %d)\n", DEFAULT_CONNECTIONS);
+    printf("  -d N             pipelined requests in flight per connection (default %d)\n", DEFAULT_DEPTH);
+    printf("  -n N             total requests (default %d)\n", DEFAULT_REQUESTS);
+}
+
+// Writes request number k of the mix: position, arrival, Hohmann and phasing queries.
+static int formatRequest(char *line, long k) {
+    double t = (double)(k % 36525) * 0.1;
+    switch (k % 4) {
+    case 0:
+        return sprintf(line, "P Earth %.1f\n", t);
+    case 1:
+        return sprintf(line, "A %.3f %.3f 0 %.1f\n", (double)(k % 3000) / 1000.0, 0.25, t);
+    case 2:
+        return sprintf(line, "H 1 %.3f\n", 1.0 + (double)(k % 500) / 100.0);
+    default:
+        return sprintf(line, "H 1 1 %.3f %.3f\n", 0.6, (double)(k % 1600) / 1000.0 - 0.8);
+    }
+}
+
+static int connectTo(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+        return -1;
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    const char *socketPath = NULL;
+    int connections = DEFAULT_CONNECTIONS, depth = DEFAULT_DEPTH, option;
+    long requests = DEFAULT_REQUESTS;
+    while ((option = getopt(argc, argv, "s:c:d:n:h")) != -1) {
+        if (option == 's') {
+            socketPath = optarg;
+        } else if (option == 'c') {
+            connections = atoi(optarg);
+        } else if (option == 'd') {
+            depth = atoi(optarg);
+        } else if (option == 'n') {
+            requests = atol(optarg);
+        } else {
+            printUsage(argv[0]);
+            exit(option == 'h' ? 0 : 1);
+        }
+    }
+    if (socketPath == NULL || connections < 1 || depth < 1 || requests < 1) {
+        printUsage(argv[0]);
+        exit(1);
+    }
+
+    LoadConnection *conns = calloc(connections, sizeof(LoadConnection));
+    struct pollfd *fds = calloc(connections, sizeof(struct pollfd));
+    double *latency = malloc(sizeof(double) * requests);
+    if (conns == NULL || fds == NULL || latency == NULL) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    for (int c = 0; c < connections; c++) {
+        LoadConnection *conn = &conns[c];
+        conn->quota = requests / connections + (c < requests % connections);
+        conn->sentAt = malloc(sizeof(double) * depth);
+        conn->output = malloc((size_t)depth * MAX_REQUEST_LINE);
+        conn->fd = connectTo(socketPath);
+        if (conn->sentAt == NULL || conn->output == NULL || conn->fd < 0) {
+            fprintf(stderr, "Error: could not connect to %s\n", socketPath);
+            exit(1);
+        }
+    }
+
+    long answered = 0, errors = 0, next = 0;
+    double start = nowSeconds();
+    while (answered < requests) {
+        for (int c = 0; c < connections; c++) {
+            LoadConnection *conn = &conns[c];
+            // Top the pipeline up, then send everything pending in one write.
+            if (conn->outputSent == conn->outputLength)
+                conn->outputLength = conn->outputSent = 0;
+            double now = nowSeconds();
+            while (conn->issued < conn->quota && conn->issued - conn->answered < depth &&
+                   conn->outputLength + MAX_REQUEST_LINE <= (size_t)depth * MAX_REQUEST_LINE) {
+                conn->outputLength += (size_t)formatRequest(conn->output + conn->outputLength, next++);
+                conn->sentAt[conn->issued++ % depth] = now;
+            }
+            while (conn->outputSent < conn->outputLength) {
+                ssize_t written = send(conn->fd, conn->output + conn->outputSent,
+                                       conn->outputLength - conn->outputSent, MSG_NOSIGNAL);
+                if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    perror("send");
+                    exit(1);
+                }
+                if (written < 0)
+                    break;
+                conn->outputSent += (size_t)written;
+            }
+            fds[c].fd = conn->answered < conn->quota ? conn->fd : -1;
+            fds[c].events = POLLIN | (conn->outputSent < conn->outputLength ? POLLOUT : 0);
+        }
+        if (poll(fds, (nfds_t)connections, 1000) < 0 && errno != EINTR) {
+            perror("poll");
+            exit(1);
+        }
+
+        for (int c = 0; c < connections; c++) {
+            LoadConnection *conn = &conns[c];
+            if (!(fds[c].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            ssize_t received = read(conn->fd, conn->input + conn->inputLength,
+                                    sizeof(conn->input) - conn->inputLength);
+            if (received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR)) {
+                fprintf(stderr, "Error: the daemon closed connection %d\n", c);
+                exit(1);
+            }
+            if (received < 0)
+                continue;
+            conn->inputLength += (size_t)received;
+            double now = nowSeconds();
+            char *line = conn->input, *end = conn->input + conn->inputLength, *newline;
+            while ((newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+                if (line[0] == 'E')
+                    errors++;
+                latency[answered++] = now - conn->sentAt[conn->answered++ % depth];
+                line = newline + 1;
+            }
+            conn->inputLength = (size_t)(end - line);
+            memmove(conn->input, line, conn->inputLength);
+        }
+    }
+    double elapsed = nowSeconds() - start;
+
+    qsort(latency, requests, sizeof(double), compareDoubles);
+    printf("%ld requests over %d connections (depth %d) in %.3f s: %.0f requests/s, %ld errors\n",
+           requests, connections, depth, elapsed, requests / elapsed, errors);
+    printf("latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+           latency[requests / 2] * 1e6, latency[requests * 9 / 10] * 1e6, latency[requests * 99 / 100] * 1e6,
+           latency[requests * 999 / 1000] * 1e6, latency[requests - 1] * 1e6);
+
+    for (int c = 0; c < connections; c++) {
+        close(conns[c].fd);
+        free(conns[c].sentAt);
+        free(conns[c].output);
+    }
+    free(conns);
+    free(fds);
+    free(latency);
+    return 0;
+}
@@ -1,9 +1,85 @@
 #include "navigation.h"
 #include "planet.h"
 #include "destinations.h"  // If you want to use printDestinations() or getDestinationByName() elsewhere.
+#include "chebyshev.h"
+#include "ephemfile.h"
+#include "batch.h"
+#include "journal.h"
+#include "server.h"
+#include "instrument.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+// Settings for ephemeris files written with -w.
+#define EPHEMERIS_DEGREE 12
+#define EPHEMERIS_TOLERANCE 1e-9  // in AU
+
+// Departure time of a new mission, in days.
+#define INITIAL_TIME 100.0
+
+void printUsage(const char *program) {
+    printf("Usage: %s [-b script] [-e ephemeris.bin] [-j journal] [-r journal [-t time]]\n"
+           "       [-s socket] [-w ephemeris.bin [-y years]] [catalog]\n", program);
+    printf("  catalog          destination catalog file (default: built-in planets)\n");
+    printf("  -b FILE          run commands from FILE ('-' for stdin) without prompts\n");
+    printf("  -e FILE          map a precomputed ephemeris file (catalog included)\n");
+    printf("  -j FILE          append every travel and arrival to a mission journal\n");
+    printf("  -r FILE          replay a mission journal and exit\n");
+    printf("  -t DAYS          with -r, show only the state at that time\n");
+    printf("  -s SOCKET        answer batch commands on a Unix domain socket until interrupted\n");
+    printf("  -w FILE          write an ephemeris file for the catalog and exit\n");
+    printf("  -y YEARS         span covered by -w, starting at day 0 (default 10)\n");
+}
+
+// Prints every entry of a journal, or with atTime only the state then.
+int replayJournal(const char *path, const char *atTime) {
+    JournalReader reader;
+    if (journalOpen(path, &reader) != 0)
+        return 1;
+    int named = journalMatchesCatalog(&reader);
+    if (!named)
+        fprintf(stderr, "Warning: %s was written for another catalog; showing body indices.\n", path);
+    OutputBuffer out;
+    outputInit(&out, 1 << 16, stdout);
+    JournalCursor cursor;
+    journalRewind(&cursor);
+    int status = atTime != NULL ? journalSeek(&reader, atof(atTime), &cursor) : journalNext(&reader, &cursor);
+    while (status == 1) {
+        const JournalEntry *entry = &cursor.entry;
+        outputPrintf(&out, "%.10g %.10g %.10g %.10g ", entry->time,
+                     entry->position.x, entry->position.y, entry->position.z);
+        if (entry->destination < 0)
+            outputPrintf(&out, "Unknown\n");
+        else if (named)
+            outputPrintf(&out, "%s\n", knownDestinations[entry->destination].name);
+        else
+            outputPrintf(&out, "#%d\n", entry->destination);
+        status = atTime != NULL ? 0 : journalNext(&reader, &cursor);
+    }
+    outputFree(&out);
+    journalClose(&reader);
+    if (status < 0)
+        fprintf(stderr, "%s: corrupt journal\n", path);
+    return status < 0 ? 1 : 0;
+}
+
+// Builds a Chebyshev cache over the current catalog and writes it out.
+int writeEphemeris(const char *path, double years) {
+    EphemerisCache cache;
+    if (ephemerisCacheBuild(&cache, getDestinationBodySet(), 0.0, years * 365.25,
+                            EPHEMERIS_DEGREE, EPHEMERIS_TOLERANCE) != 0) {
+        printf("Error: could not build the ephemeris cache.\n");
+        return 1;
+    }
+    int status = writeEphemerisFile(path, &cache);
+    if (status == 0)
+        printf("Wrote %s: %d bodies, %.1f years, %ld bytes of coefficients.\n",
+               path, cache.bodyCount, years, ephemerisCacheBytes(&cache));
+    ephemerisCacheFree(&cache);
+    return status == 0 ? 0 : 1;
+}
 
 void printMenu(void) {
     printf("\n--- Navigation Console ---\n");
@@ -16,7 +92,55 @@ void printMenu(void) {
     printf("0 > Quit\n");
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    INSTR_INIT();
+    const char *ephemerisPath = NULL, *writePath = NULL, *batchPath = NULL;
+    const char *journalPath = NULL, *replayPath = NULL, *replayTime = NULL, *socketPath = NULL;
+    double years = 10.0;
+    int option;
+    while ((option = getopt(argc, argv, "b:e:j:r:s:t:w:y:h")) != -1) {
+        if (option == 'b') {
+            batchPath = optarg;
+        } else if (option == 'e') {
+            ephemerisPath = optarg;
+        } else if (option == 'j') {
+            journalPath = optarg;
+        } else if (option == 'r') {
+            replayPath = optarg;
+        } else if (option == 's') {
+            socketPath = optarg;
+        } else if (option == 't') {
+            replayTime = optarg;
+        } else if (option == 'w') {
+            writePath = optarg;
+        } else if (option == 'y') {
+            years = atof(optarg);
+        } else {
+            printUsage(argv[0]);
+            exit(option == 'h' ? 0 : 1);
+        }
+    }
+
+    // Optionally replace the built-in destinations with a catalog file.
+    if (optind < argc && loadDestinations(argv[optind]) < 0) {
+        printf("Error: could not load destination catalog %s\n", argv[optind]);
+        exit(1);
+    }
+    if (writePath != NULL)
+        return writeEphemeris(writePath, years);
+
+    // A mapped ephemeris file replaces the catalog and serves arrival checks.
+    EphemerisFile ephemeris;
+    if (ephemerisPath != NULL) {
+        if (openEphemerisFile(ephemerisPath, &ephemeris) != 0) {
+            printf("Error: could not open ephemeris file %s\n", ephemerisPath);
+            exit(1);
+        }
+        setNavigationEphemerisCache(&ephemeris.cache);
+    }
+    if (replayPath != NULL)
+        return replayJournal(replayPath, replayTime);
+
     // Retrieve Earth from the destinations module.
     Planet *earth = getDestinationByName("Earth");
     if (earth == NULL) {
@@ -27,14 +151,51 @@ int main(void) {
     // Retrieve Mars similarly if needed.
     Planet *mars = getDestinationByName("Mars");
     
+    // Daemon mode: every connection gets its own ship starting at Earth.
+    if (socketPath != NULL)
+        return runServer(socketPath, earth, INITIAL_TIME) == 0 ? 0 : 1;
+
     // Initialize your ship state using Earth.
     ShipState state;
-    state.currentTime = 100.0;
-    state.shipPosition = getPlanetPosition(*earth, state.currentTime);
-    strcpy(state.currentDestination.name, earth->name);
-    strcpy(state.currentDestination.description, "Earth: our vibrant blue home planet.");
-    state.currentDestination.position = state.shipPosition;
-    state.currentDestination.arrivalTime = state.currentTime;
+    initShipState(&state, earth, INITIAL_TIME);
+
+    // A new journal starts with the initial state and an existing one resumes
+    // the mission where it stopped; navigation appends the rest.
+    JournalWriter journal;
+    if (journalPath != NULL) {
+        JournalEntry last;
+        int status = journalOpenWriter(journalPath, &journal);
+        if (status == 0 && journalLastEntry(&journal, &last)) {
+            state.shipPosition = last.position;
+            state.currentTime = last.time;
+            if (determineDestination(state.shipPosition, state.currentTime, &state) != 0) {
+                printf("Error: out of memory\n");
+                exit(1);
+            }
+        } else if (status == 0) {
+            status = journalAppend(&journal, &state);
+        }
+        if (status != 0) {
+            printf("Error: could not write mission journal %s\n", journalPath);
+            exit(1);
+        }
+        setNavigationJournal(&journal);
+    }
+
+    // Batch mode: no prompts or banners, one result line per command.
+    if (batchPath != NULL) {
+        FILE *script = strcmp(batchPath, "-") == 0 ? stdin : fopen(batchPath, "r");
+        if (script == NULL) {
+            printf("Error: could not open batch script %s\n", batchPath);
+            exit(1);
+        }
+        int failures = runBatch(script, stdout, &state);
+        if (script != stdin)
+            fclose(script);
+        if (journalPath != NULL)
+            journalCloseWriter(&journal);
+        return failures == 0 ? 0 : 1;
+    }
     
     printf("\nYou are on << Mineral-Raider-1 >>\n");
     printInfo(&state);
@@ -44,6 +205,8 @@ int main(void) {
     while (1) {
         printf("System Option ('M' for menu) >> ");
         scanf(" %c", &choice);
+        INSTR_POLL();
+        INSTR_TIMER_START(command);
         
         if (choice == 'D' || choice == 'd') {
             printDestinations();
@@ -63,6 +226,7 @@ int main(void) {
         } else {
             printf("Invalid choice. Please try again.\n");
         }
+        INSTR_COMMAND_STOP(command, choice);
     }
     
     return 0;
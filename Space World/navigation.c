@@ -1,15 +1,15 @@
 #include "navigation.h"
 #include "planet.h"
+#include "approach.h"
+#include "destinations.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
-#include <string.h>
 
-#define THRESHOLD 0.1  // in AU
-#define PI 3.141592653589793
+#define THRESHOLD ARRIVAL_THRESHOLD  // in AU
 
 // Prints ship status info with custom formatting.
-void printInfo(ShipState *state) {
+void printInfo(const ShipState *state) {
     double distanceFromSun = sqrt(state->shipPosition.x * state->shipPosition.x +
                                   state->shipPosition.y * state->shipPosition.y);
     printf("Space-Time Information:\n");
@@ -34,26 +34,6 @@ void printFormulae(void) {
     printf("Z = 0.0 (2D approximation: movement in the ecliptic plane only)\n");
 }
 
-// Computes Hohmann transfer time (in days) between two orbits.
-// Returns 0 if radii are nearly identical.
-double computeHohmannTransferTime(double r1, double r2) {
-    if (fabs(r1 - r2) < 1e-6)
-        return 0.0;
-    double a_transfer = (r1 + r2) / 2.0;
-    double period_transfer = 365.25 * pow(a_transfer, 1.5);
-    return period_transfer / 2.0;
-}
-
-// Computes phasing time for same-orbit transfers based on angular difference.
-double computePhasingTime(Vector3D current, Vector3D target, double orbitalPeriod) {
-    double angleCurrent = atan2(current.y, current.x);
-    double angleTarget  = atan2(target.y, target.x);
-    double dtheta = fabs(angleTarget - angleCurrent);
-    if (dtheta > PI)
-        dtheta = 2 * PI - dtheta;
-    return (dtheta / (2 * PI)) * orbitalPeriod;
-}
-
 // Displays Hohmann or phasing transfer time based on input orbit radii.
 void hohmannTransferTime(ShipState *state) {
     double playerOrbitRadius, destinationOrbitRadius;
@@ -90,48 +70,134 @@ void travelSystemExecute(ShipState *state) {
   scanf("%lf", &playerCalculated.z);
   printf("Enter your travel duration (in days): ");
   scanf("%lf", &travelDuration);
-  
+
+  // Report bodies passed on the way, not only the one at the end.
+  if (travelDuration > 0.0) {
+    ShipPath path = { state->shipPosition,
+                      { (playerCalculated.x - state->shipPosition.x) / travelDuration,
+                        (playerCalculated.y - state->shipPosition.y) / travelDuration,
+                        (playerCalculated.z - state->shipPosition.z) / travelDuration },
+                      state->currentTime, state->currentTime + travelDuration };
+    CloseApproach flybys[8];
+    int found = findCloseApproaches(&path, THRESHOLD, 0, flybys, 8);
+    for (int k = 0; k < found && k < 8; k++) {
+      printf("Passed within %.4f AU of %s at day %.2f.\n", flybys[k].distance,
+             knownDestinations[flybys[k].body].name, flybys[k].time);
+    }
+  }
+
   // Update the ship's state.
   state->shipPosition = playerCalculated;
   state->currentTime += travelDuration;  // Add travel duration to current time.
   updateCurrentDestination(state, state->currentTime);
 }
 
+static void journalTransition(const ShipState *state);
+static void arriveAt(Vector3D pos, double time, ShipState *state);
+
+// Places the ship at origin (a known destination) at time, arrived there.
+void initShipState(ShipState *state, const Planet *origin, double time) {
+    state->currentTime = time;
+    state->shipPosition = getDestinationPosition((int)(origin - knownDestinations), time);
+    arriveAt(state->shipPosition, time, state);
+}
+
+// Moves the ship to position after duration days and detects the arrival, without any I/O.
+void travelTo(ShipState *state, Vector3D position, double duration) {
+    state->shipPosition = position;
+    state->currentTime += duration;
+    arriveAt(state->shipPosition, state->currentTime, state);
+    journalTransition(state);
+}
+
 
 // Determines the current destination by comparing the ship's position with known planets.
 #include "destinations.h" // Include your destinations module
+#include "spatial.h"
+#include "chebyshev.h"
+#include "instrument.h"
+#include "journal.h"
+
+// Arrival index over the known destinations, rebuilt when the epoch or catalog changes.
+static SpatialGrid arrivalGrid;
+static unsigned arrivalGridGeneration = 0;
+static const EphemerisCache *navigationCache = NULL;
+static unsigned navigationCacheGeneration = 0;  // catalog the cache was built for
+static JournalWriter *navigationJournal = NULL;
 
-void determineDestination(Vector3D pos, double time, ShipState *state) {
-    // Loop over all known destinations.
-    Planet *destinationFound = NULL;
-    for (int i = 0; i < knownDestinationsCount; i++) {
-        Vector3D destPos = getPlanetPosition(knownDestinations[i], time);
-        double d = calculateDistance(pos, destPos);
-        if (d < THRESHOLD) {
-            destinationFound = &knownDestinations[i];
-            break;
+void setNavigationEphemerisCache(const EphemerisCache *cache) {
+    navigationCache = cache;
+    navigationCacheGeneration = getDestinationGeneration();
+    arrivalGrid.time = NAN;  // Force a rebuild from the new source.
+}
+
+// The cache, if it was built for the current catalog; a reloaded catalog of
+// the same size is a different set of bodies.
+static const EphemerisCache *currentCache(void) {
+    if (navigationCacheGeneration != getDestinationGeneration())
+        return NULL;
+    return navigationCache;
+}
+
+NavContext navigationContext(void) {
+    NavContext context;
+    navContextInit(&context, knownDestinations, getDestinationBodySet());
+    context.cache = currentCache();
+    return context;
+}
+
+void setNavigationJournal(JournalWriter *journal) {
+    navigationJournal = journal;
+}
+
+// Records a state transition in the journal, if one is open.
+static void journalTransition(const ShipState *state) {
+    if (navigationJournal != NULL && journalAppend(navigationJournal, state) != 0)
+        fprintf(stderr, "Warning: could not write the mission journal.\n");
+}
+
+int determineDestination(Vector3D pos, double time, ShipState *state) {
+    INSTR_TIMER_START(call);
+    INSTR_COUNT(COUNTER_DETERMINE_DESTINATION, 1);
+    BodySet bodies = getDestinationBodySet();
+    if (arrivalGrid.cellSize == 0.0)
+        spatialGridInit(&arrivalGrid, THRESHOLD);
+    if (arrivalGrid.time != time || arrivalGridGeneration != getDestinationGeneration() ||
+        arrivalGrid.count != bodies.count) {
+        INSTR_TIMER_START(trig);
+        INSTR_COUNT(COUNTER_ARRIVAL_GRID_REBUILDS, 1);
+        const EphemerisCache *cache = currentCache();
+        if (cache != NULL && cache->bodyCount == bodies.count &&
+            time >= cache->startTime && time <= cache->endTime) {
+            if (spatialGridReserve(&arrivalGrid, bodies.count) != 0)
+                return -1;
+            ephemerisCachePositions(cache, time, arrivalGrid.x, arrivalGrid.y, arrivalGrid.z);
+            spatialGridRefit(&arrivalGrid, time);
+        } else if (spatialGridBuild(&arrivalGrid, bodies, time) != 0) {
+            return -1;
         }
+        arrivalGridGeneration = getDestinationGeneration();
+        INSTR_COUNT(COUNTER_ARRIVAL_POSITIONS, (uint64_t)bodies.count);
+        INSTR_TIMER_STOP(trig, TIMER_TRIG);
     }
 
-    if (destinationFound != NULL) {
-         strcpy(state->currentDestination.name, destinationFound->name);
-         // For description, you might hard-code some or call a helper function.
-         if (strcmp(destinationFound->name, "Earth") == 0) {
-             strcpy(state->currentDestination.description, "Earth: our vibrant blue home planet.");
-         } else if (strcmp(destinationFound->name, "Mars") == 0) {
-             strcpy(state->currentDestination.description, "Mars: the Red Planet, a potential destination for exploration.");
-         } else if (strcmp(destinationFound->name, "Saturn") == 0) {
-             strcpy(state->currentDestination.description, "Saturn: adorned with magnificent rings.");
-         } else {
-             strcpy(state->currentDestination.description, "A known celestial destination.");
-         }
-         state->currentDestination.position = getPlanetPosition(*destinationFound, time);
-         state->currentDestination.arrivalTime = time;
-    } else {
-         strcpy(state->currentDestination.name, "Unknown");
-         strcpy(state->currentDestination.description, "You have arrived at an unknown celestial destination.");
-         state->currentDestination.position = pos;
-         state->currentDestination.arrivalTime = time;
+    // The library's arrival detection, served from the grid.
+    INSTR_TIMER_START(distance);
+    NavContext context = navigationContext();
+    context.grid = &arrivalGrid;
+    navDetermineDestination(&context, state, pos, time);
+    INSTR_TIMER_STOP(distance, TIMER_DISTANCE);
+    INSTR_TIMER_STOP(call, TIMER_DETERMINE_DESTINATION);
+    return 0;
+}
+
+// determineDestination for the console's own moves, which have no way to
+// report failure: running out of memory for the arrival index ends the
+// process, as it does for the catalog.
+static void arriveAt(Vector3D pos, double time, ShipState *state) {
+    if (determineDestination(pos, time, state) != 0) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
     }
 }
 
@@ -139,6 +205,7 @@ void determineDestination(Vector3D pos, double time, ShipState *state) {
 // Updates the current destination in the ShipState.
 void updateCurrentDestination(ShipState *state, double arrivalTime) {
     state->currentTime = arrivalTime;
-    determineDestination(state->shipPosition, state->currentTime, state);
+    arriveAt(state->shipPosition, state->currentTime, state);
+    journalTransition(state);
     printf("You have arrived at %s.\n", state->currentDestination.name);
 }
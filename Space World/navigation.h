@@ -2,27 +2,36 @@
 #define NAVIGATION_H
 
 #include "planet.h"
+#include "chebyshev.h"
+#include "spacenav.h"
 
-// ShipState structure encapsulates the ship's state.
-typedef struct {
-    double currentTime;
-    Vector3D shipPosition;
-    struct {
-        char name[64];
-        char description[256];
-        Vector3D position;
-        double arrivalTime;
-    } currentDestination;
-} ShipState;
+// The console's side of navigation: prompts, messages, the known
+// destinations and process-wide settings. The computations are in
+// libspacenav (spacenav.h).
 
 // Function prototypes for navigation functions.
-void printInfo(ShipState *state);
+void printInfo(const ShipState *state);
 void printFormulae(void);
-double computeHohmannTransferTime(double r1, double r2);
-double computePhasingTime(Vector3D current, Vector3D target, double orbitalPeriod);
 void hohmannTransferTime(ShipState *state);
 void travelSystemExecute(ShipState *state);
-void determineDestination(Vector3D pos, double time, ShipState *state);
+void travelTo(ShipState *state, Vector3D position, double duration);
+void initShipState(ShipState *state, const Planet *origin, double time);
+// Sets state's destination from the body within the arrival threshold of pos
+// at time. Returns 0, or -1 if the arrival index could not be allocated
+// (state is left unchanged).
+int determineDestination(Vector3D pos, double time, ShipState *state);
 void updateCurrentDestination(ShipState *state, double arrivalTime);
 
+// Library context over the known destinations and the cache set below.
+NavContext navigationContext(void);
+
+// Serves arrival detection from a Chebyshev cache when it covers the time
+// (NULL, the default, uses the analytic orbits).
+void setNavigationEphemerisCache(const EphemerisCache *cache);
+
+// Appends the ship's state to journal after every travel and arrival
+// (NULL, the default, keeps no history).
+struct JournalWriter;
+void setNavigationJournal(struct JournalWriter *journal);
+
 #endif
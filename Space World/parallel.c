@@ -0,0 +1,150 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MAX_PARALLEL_THREADS 256
+
+// Work stealing: each participant owns a contiguous range of chunks, packed as
+// (end << 32 | next) so the owner (taking from the front) and thieves (taking
+// from the back) can both claim chunks with one compare-and-swap.
+typedef struct {
+    _Atomic uint64_t range;
+    char padding[64 - sizeof(uint64_t)];  // one range per cache line
+} WorkQueue;
+
+// The pool's workers sleep until a new job generation is published.
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t poolDone = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t callLock = PTHREAD_MUTEX_INITIALIZER;
+static int poolSize = 0;          // worker threads, not counting callers
+static unsigned long generation = 0;
+
+// Current job. The caller is participant 0 and worker i is participant i + 1;
+// workers with an id >= jobWorkers sit the job out.
+static ParallelTask jobTask;
+static void *jobContext;
+static int jobCount, jobChunk, jobWorkers;
+static int jobActive;             // workers still running the job
+static WorkQueue queues[MAX_PARALLEL_THREADS];
+
+int parallelDefaultThreads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+// Claims one chunk from a queue, from the front for the owner and from the
+// back for a thief. Returns the chunk index, or -1 if the queue is empty.
+static int claimChunk(WorkQueue *queue, int steal) {
+    uint64_t range = atomic_load(&queue->range);
+    for (;;) {
+        uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (next >= end)
+            return -1;
+        uint64_t claimed = steal ? ((uint64_t)(end - 1) << 32 | next)
+                                 : ((uint64_t)end << 32 | (next + 1));
+        if (atomic_compare_exchange_weak(&queue->range, &range, claimed))
+            return (int)(steal ? end - 1 : next);
+    }
+}
+
+static void runChunk(int chunk) {
+    int begin = chunk * jobChunk;
+    int end = jobCount - begin < jobChunk ? jobCount : begin + jobChunk;
+    jobTask(jobContext, begin, end);
+}
+
+// Drains the participant's own queue, then steals from the others.
+static void runParticipant(int self, int participants) {
+    int chunk;
+    while ((chunk = claimChunk(&queues[self], 0)) >= 0)
+        runChunk(chunk);
+    for (int k = 1; k < participants; k++) {
+        WorkQueue *victim = &queues[(self + k) % participants];
+        while ((chunk = claimChunk(victim, 1)) >= 0)
+            runChunk(chunk);
+    }
+}
+
+static void *poolWorker(void *arg) {
+    int id = (int)(long)arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&poolLock);
+    for (;;) {
+        while (generation == seen)
+            pthread_cond_wait(&poolWake, &poolLock);
+        seen = generation;
+        if (id >= jobWorkers)
+            continue;
+        int participants = jobWorkers + 1;
+        pthread_mutex_unlock(&poolLock);
+
+        runParticipant(id + 1, participants);
+
+        pthread_mutex_lock(&poolLock);
+        if (--jobActive == 0)
+            pthread_cond_signal(&poolDone);
+    }
+    return NULL;
+}
+
+// Starts workers until the pool has at least size threads.
+static void growPool(int size) {
+    while (poolSize < size) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, poolWorker, (void *)(long)poolSize) != 0)
+            break;
+        pthread_detach(thread);
+        poolSize++;
+    }
+}
+
+void parallelFor(int count, int chunkSize, int threads, ParallelTask task, void *context) {
+    if (count <= 0)
+        return;
+    if (chunkSize < 1)
+        chunkSize = 1;
+    if (threads <= 0)
+        threads = parallelDefaultThreads();
+    if (threads > MAX_PARALLEL_THREADS)
+        threads = MAX_PARALLEL_THREADS;
+    int chunks = (count + chunkSize - 1) / chunkSize;
+    if (threads > chunks)
+        threads = chunks;
+    if (threads == 1) {
+        task(context, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&callLock);
+    pthread_mutex_lock(&poolLock);
+    growPool(threads - 1);
+    jobTask = task;
+    jobContext = context;
+    jobCount = count;
+    jobChunk = chunkSize;
+    jobWorkers = threads - 1 < poolSize ? threads - 1 : poolSize;
+    jobActive = jobWorkers;
+
+    // Deal the chunks out evenly; stealing evens out any imbalance.
+    int participants = jobWorkers + 1;
+    for (int p = 0; p < participants; p++) {
+        uint64_t first = (uint64_t)chunks * p / participants;
+        uint64_t last = (uint64_t)chunks * (p + 1) / participants;
+        atomic_store(&queues[p].range, last << 32 | first);
+    }
+    generation++;
+    pthread_cond_broadcast(&poolWake);
+    pthread_mutex_unlock(&poolLock);
+
+    runParticipant(0, participants);
+
+    pthread_mutex_lock(&poolLock);
+    while (jobActive > 0)
+        pthread_cond_wait(&poolDone, &poolLock);
+    pthread_mutex_unlock(&poolLock);
+    pthread_mutex_unlock(&callLock);
+}
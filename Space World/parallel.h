@@ -0,0 +1,15 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Work function: processes items [begin, end) of a parallel loop.
+typedef void (*ParallelTask)(void *context, int begin, int end);
+
+// Number of online CPUs (at least 1).
+int parallelDefaultThreads(void);
+
+// Runs task over [0, count) in chunks of chunkSize on a shared, work-stealing thread pool.
+// threads <= 0 uses every CPU. The calling thread takes part and the call
+// returns once every chunk is done. Calls from several threads are serialized.
+void parallelFor(int count, int chunkSize, int threads, ParallelTask task, void *context);
+
+#endif
@@ -1,8 +1,16 @@
 #include "planet.h"
 #include <math.h>
+#include <stddef.h>
 #define PI 3.141592653589793
 
+NavCountHook navCountHook = NULL;
+
+void setNavCountHook(NavCountHook hook) {
+    navCountHook = hook;
+}
+
 Vector3D getPlanetPosition(Planet planet, double time) {
+    NAV_COUNT(NAV_COUNT_PLANET_POSITION, 1);
     double angle = 2 * PI * (time / planet.orbitalPeriod);
     Vector3D pos;
     pos.x = planet.orbitRadius * cos(angle);
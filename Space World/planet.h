@@ -16,4 +16,24 @@ typedef struct {
 Vector3D getPlanetPosition(Planet planet, double time);
 double calculateDistance(Vector3D a, Vector3D b);
 
+// Position counts libspacenav reports when built with -DSPACENAV_INSTRUMENT.
+// The library has no counters of its own; it calls the hook set here, if
+// any, so it never links against the console's instrumentation.
+typedef enum {
+    NAV_COUNT_PLANET_POSITION,   // getPlanetPosition calls
+    NAV_COUNT_BATCH_POSITIONS    // bodies evaluated by computePositionsBatch(F)
+} NavCount;
+typedef void (*NavCountHook)(NavCount count, unsigned long long amount);
+
+// Installs hook (NULL: none, the default). Set it before any other thread
+// uses the library.
+void setNavCountHook(NavCountHook hook);
+
+#ifdef SPACENAV_INSTRUMENT
+extern NavCountHook navCountHook;
+#define NAV_COUNT(count, amount) (navCountHook != NULL ? navCountHook(count, amount) : (void)0)
+#else
+#define NAV_COUNT(count, amount) ((void)0)
+#endif
+
 #endif
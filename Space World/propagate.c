@@ -0,0 +1,223 @@
+#include "propagate.h"
+#include "lambert.h"
+#include <math.h>
+#include <string.h>
+
+#define PROPAGATE_BLOCK 64     // ships integrated together, on the stack
+#define RK45_MIN_STEP 1e-12    // of the duration; a smaller step means a singularity
+
+// Perturber positions at one time, shared by every ship of a block.
+typedef struct {
+    int count;
+    double x[PROPAGATE_MAX_PERTURBERS], y[PROPAGATE_MAX_PERTURBERS], z[PROPAGATE_MAX_PERTURBERS];
+    double gm[PROPAGATE_MAX_PERTURBERS];
+    double ix[PROPAGATE_MAX_PERTURBERS], iy[PROPAGATE_MAX_PERTURBERS], iz[PROPAGATE_MAX_PERTURBERS];
+} Perturbers;
+
+void propagateOptionsInit(PropagateOptions *options, PropagateMethod method, double step) {
+    memset(options, 0, sizeof(*options));
+    options->method = method;
+    options->step = step;
+    options->tolerance = PROPAGATE_DEFAULT_TOLERANCE;
+}
+
+static void perturbersAt(const PropagateOptions *options, double time, Perturbers *perturbers) {
+    perturbers->count = options->perturberCount;
+    for (int j = 0; j < options->perturberCount; j++) {
+        Vector3D p = getPlanetPosition(options->perturbers[j], time);
+        double r2 = p.x * p.x + p.y * p.y + p.z * p.z;
+        double gm = options->perturberGM[j];
+        // The Sun is pulled by the planet too; in the Sun's frame that is a
+        // uniform acceleration the ships do not feel.
+        double indirect = r2 > 0.0 ? gm / (r2 * sqrt(r2)) : 0.0;
+        perturbers->x[j] = p.x;
+        perturbers->y[j] = p.y;
+        perturbers->z[j] = p.z;
+        perturbers->gm[j] = gm;
+        perturbers->ix[j] = indirect * p.x;
+        perturbers->iy[j] = indirect * p.y;
+        perturbers->iz[j] = indirect * p.z;
+    }
+}
+
+// Accelerations (AU/day^2) of count ships at x, y, z. Branch-free over ships.
+static void accelerations(const PropagateOptions *options, double time, int count,
+                          const double *x, const double *y, const double *z,
+                          double *ax, double *ay, double *az) {
+    for (int i = 0; i < count; i++) {
+        double r2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        double k = -SUN_GM / (r2 * sqrt(r2));
+        ax[i] = k * x[i];
+        ay[i] = k * y[i];
+        az[i] = k * z[i];
+    }
+    if (options->perturberCount == 0)
+        return;
+    Perturbers p;
+    perturbersAt(options, time, &p);
+    for (int j = 0; j < p.count; j++) {
+        for (int i = 0; i < count; i++) {
+            double dx = p.x[j] - x[i], dy = p.y[j] - y[i], dz = p.z[j] - z[i];
+            double d2 = dx * dx + dy * dy + dz * dz;
+            double k = p.gm[j] / (d2 * sqrt(d2));
+            ax[i] += k * dx - p.ix[j];
+            ay[i] += k * dy - p.iy[j];
+            az[i] += k * dz - p.iz[j];
+        }
+    }
+}
+
+// One block's state: s[0..2] positions, s[3..5] velocities.
+typedef double BlockState[6][PROPAGATE_BLOCK];
+
+// Kick-drift-kick leapfrog steps with the given weights per step; a holds the
+// accelerations at the current state and is kept up to date (first same as last).
+static void symplecticSteps(const PropagateOptions *options, double time, double h, long steps,
+                            const double *weights, int weightCount, int count, BlockState s, BlockState a) {
+    for (long n = 0; n < steps; n++) {
+        for (int w = 0; w < weightCount; w++) {
+            double hw = h * weights[w];
+            for (int c = 0; c < 3; c++) {
+                for (int i = 0; i < count; i++) {
+                    s[3 + c][i] += 0.5 * hw * a[c][i];
+                    s[c][i] += hw * s[3 + c][i];
+                }
+            }
+            time += hw;
+            accelerations(options, time, count, s[0], s[1], s[2], a[0], a[1], a[2]);
+            for (int c = 0; c < 3; c++) {
+                for (int i = 0; i < count; i++)
+                    s[3 + c][i] += 0.5 * hw * a[c][i];
+            }
+        }
+    }
+}
+
+// Dormand-Prince 5(4) tableau.
+static const double rkC[7] = { 0.0, 1.0 / 5, 3.0 / 10, 4.0 / 5, 8.0 / 9, 1.0, 1.0 };
+static const double rkA[7][6] = {
+    { 0 },
+    { 1.0 / 5 },
+    { 3.0 / 40, 9.0 / 40 },
+    { 44.0 / 45, -56.0 / 15, 32.0 / 9 },
+    { 19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729 },
+    { 9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656 },
+    { 35.0 / 384, 0.0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84 }
+};
+// Fifth- minus fourth-order weights: the local error estimate.
+static const double rkE[7] = { 71.0 / 57600, 0.0, -71.0 / 16695, 71.0 / 1920, -17253.0 / 339200,
+                               22.0 / 525, -1.0 / 40 };
+
+// Integrates the block over duration with one adaptive step size for all of
+// it, controlled by the worst ship. Returns 0, or -1 if the step collapses.
+static int rk45Block(const PropagateOptions *options, double time, double duration, long maxSteps,
+                     int count, BlockState s) {
+    BlockState k[7], trial;
+    double end = time + duration;
+    double h = options->step > 0.0 ? copysign(fmin(options->step, fabs(duration)), duration) : duration;
+    memcpy(k[0][0], s[3], sizeof(double) * PROPAGATE_BLOCK * 3);
+    accelerations(options, time, count, s[0], s[1], s[2], k[0][3], k[0][4], k[0][5]);
+    for (long steps = 0; steps < maxSteps; steps++) {
+        if (fabs(end - time) <= fabs(duration) * 1e-15)
+            return 0;
+        if (fabs(h) > fabs(end - time))
+            h = end - time;
+        for (int st = 1; st < 7; st++) {
+            for (int c = 0; c < 6; c++) {
+                for (int i = 0; i < count; i++) {
+                    double sum = 0.0;
+                    for (int j = 0; j < st; j++)
+                        sum += rkA[st][j] * k[j][c][i];
+                    trial[c][i] = s[c][i] + h * sum;
+                }
+            }
+            memcpy(k[st][0], trial[3], sizeof(double) * PROPAGATE_BLOCK * 3);
+            accelerations(options, time + rkC[st] * h, count, trial[0], trial[1], trial[2],
+                          k[st][3], k[st][4], k[st][5]);
+        }
+        // The last stage is evaluated at the fifth-order solution, now in trial.
+        double error = 0.0;
+        for (int c = 0; c < 6; c++) {
+            for (int i = 0; i < count; i++) {
+                double e = 0.0;
+                for (int j = 0; j < 7; j++)
+                    e += rkE[j] * k[j][c][i];
+                double scale = options->tolerance * (1.0 + fmax(fabs(s[c][i]), fabs(trial[c][i])));
+                error = fmax(error, fabs(h * e) / scale);
+            }
+        }
+        if (!(error == error))
+            error = INFINITY;
+        if (error <= 1.0) {
+            time = fabs(h) >= fabs(end - time) ? end : time + h;
+            memcpy(s, trial, sizeof(BlockState));
+            memcpy(k[0], k[6], sizeof(BlockState));
+        }
+        double factor = error > 0.0 ? 0.9 * pow(error, -0.2) : 5.0;
+        h *= fmin(5.0, fmax(0.2, factor));
+        if (fabs(h) < fabs(duration) * RK45_MIN_STEP)
+            return -1;
+    }
+    return -1;
+}
+
+int propagateShips(ShipBatch ships, double startTime, double duration, const PropagateOptions *options) {
+    if (options->perturberCount < 0 || options->perturberCount > PROPAGATE_MAX_PERTURBERS ||
+        (options->perturberCount > 0 && (options->perturbers == NULL || options->perturberGM == NULL)))
+        return -1;
+    if (options->method == PROPAGATE_RK45 ? !(options->tolerance > 0.0) : !(options->step > 0.0))
+        return -1;
+    if (options->method != PROPAGATE_LEAPFROG && options->method != PROPAGATE_YOSHIDA &&
+        options->method != PROPAGATE_RK45)
+        return -1;
+    if (duration == 0.0 || ships.count <= 0)
+        return 0;
+
+    // The step count only exists for the symplectic methods; RK45 may have no step.
+    long maxSteps = options->maxSteps > 0 && options->maxSteps < PROPAGATE_MAX_STEPS ? options->maxSteps
+                                                                                     : PROPAGATE_MAX_STEPS;
+    long steps = 0;
+    double h = duration;
+    if (options->method != PROPAGATE_RK45) {
+        double stepCount = ceil(fabs(duration) / options->step);
+        if (!(stepCount <= (double)maxSteps))
+            return -1;
+        steps = (long)stepCount;
+        h = duration / (double)steps;
+    }
+
+    // Yoshida's weights: w1, w0, w1 with 2 w1 + w0 = 1 cancel the third-order error.
+    double cbrt2 = cbrt(2.0);
+    double w1 = 1.0 / (2.0 - cbrt2);
+    double yoshida[3] = { w1, -cbrt2 * w1, w1 };
+    double leapfrog[1] = { 1.0 };
+
+    BlockState s, a;
+    for (int first = 0; first < ships.count; first += PROPAGATE_BLOCK) {
+        int count = ships.count - first < PROPAGATE_BLOCK ? ships.count - first : PROPAGATE_BLOCK;
+        double *columns[6] = { ships.x, ships.y, ships.z, ships.vx, ships.vy, ships.vz };
+        for (int c = 0; c < 6; c++)
+            memcpy(s[c], columns[c] + first, sizeof(double) * count);
+
+        int status = 0;
+        if (options->method == PROPAGATE_RK45) {
+            status = rk45Block(options, startTime, duration, maxSteps, count, s);
+        } else {
+            accelerations(options, startTime, count, s[0], s[1], s[2], a[0], a[1], a[2]);
+            if (options->method == PROPAGATE_LEAPFROG)
+                symplecticSteps(options, startTime, h, steps, leapfrog, 1, count, s, a);
+            else
+                symplecticSteps(options, startTime, h, steps, yoshida, 3, count, s, a);
+        }
+
+        for (int c = 0; c < 6; c++) {
+            memcpy(columns[c] + first, s[c], sizeof(double) * count);
+            // A fixed step cannot follow a pass through a body; it shows as overflow.
+            for (int i = 0; i < count; i++)
+                status |= isfinite(s[c][i]) ? 0 : -1;
+        }
+        if (status != 0)
+            return -1;
+    }
+    return 0;
+}
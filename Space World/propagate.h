@@ -0,0 +1,64 @@
+#ifndef PROPAGATE_H
+#define PROPAGATE_H
+
+#include "planet.h"
+
+// Most perturbing planets one propagation can take.
+#define PROPAGATE_MAX_PERTURBERS 16
+
+// Most steps a propagation may take; a longer one is rejected rather than
+// left running for hours on a tiny step.
+#define PROPAGATE_MAX_STEPS 10000000L
+
+// Default local error tolerance of the adaptive method.
+#define PROPAGATE_DEFAULT_TOLERANCE 1e-12
+
+typedef enum {
+    PROPAGATE_LEAPFROG,   // kick-drift-kick, 2nd order, one force evaluation per step
+    PROPAGATE_YOSHIDA,    // Yoshida's 4th-order composition of three leapfrog steps
+    PROPAGATE_RK45        // Dormand-Prince 5(4) with an adaptive step
+} PropagateMethod;
+
+// Ships in structure-of-arrays form: heliocentric positions (AU) and
+// velocities (AU/day), propagated in place.
+typedef struct {
+    double *x, *y, *z;
+    double *vx, *vy, *vz;
+    int count;
+} ShipBatch;
+
+// The ships [first, first + count) of a batch.
+static inline ShipBatch shipBatchSlice(ShipBatch ships, int first, int count) {
+    ShipBatch slice = { ships.x + first, ships.y + first, ships.z + first,
+                        ships.vx + first, ships.vy + first, ships.vz + first, count };
+    return slice;
+}
+
+typedef struct {
+    PropagateMethod method;
+    double step;                // days: the step of the symplectic methods, the first try of RK45
+    double tolerance;           // RK45 local error per step, relative to 1 + |component|
+    const Planet *perturbers;   // planets on their circular orbits (getPlanetPosition), or NULL
+    const double *perturberGM;  // their gravitational parameters, AU^3/day^2
+    int perturberCount;
+    long maxSteps;              // most steps (RK45: attempts) per ship; 0 or more than
+                                // PROPAGATE_MAX_STEPS means PROPAGATE_MAX_STEPS
+} PropagateOptions;
+
+// Options for method with the given step, the default tolerance, the default
+// step limit and only the Sun.
+void propagateOptionsInit(PropagateOptions *options, PropagateMethod method, double step);
+
+// Moves every ship from startTime to startTime + duration under the Sun's
+// gravity and the perturbers' (with the indirect term of the heliocentric
+// frame). The symplectic methods take the whole number of equal steps no
+// longer than step that covers duration, so their energy error stays bounded
+// over long runs. RK45 shares one step size across each block of ships.
+// Does no I/O and allocates nothing; separate batches may be propagated
+// concurrently. Returns 0, or -1 on bad options (including a symplectic run
+// of more than maxSteps steps), if RK45 cannot meet the
+// tolerance or a ship ends up non-finite (a pass through the Sun or a
+// planet), leaving the ships partly moved.
+int propagateShips(ShipBatch ships, double startTime, double duration, const PropagateOptions *options);
+
+#endif
@@ -0,0 +1,262 @@
+#include "server.h"
+#include "batch.h"
+#include "navigation.h"
+#include "instrument.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define REPLY_BUFFER_SIZE 4096
+
+typedef struct {
+    int fd;
+    char input[SERVER_MAX_LINE];
+    size_t inputLength;
+    int discarding;     // dropping the rest of an over-long line
+    int lineNumber;
+    int peerClosed;     // no more requests; close once the replies are out
+    OutputBuffer output;
+    size_t sent;        // bytes of output already written
+    ShipState state;
+} ServerClient;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+static int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags < 0 ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Binds and listens on path, replacing a stale socket file but not a live daemon.
+static int openListener(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0) {
+        fprintf(stderr, "%s: a daemon is already listening\n", path);
+        close(probe);
+        return -1;
+    }
+    if (probe >= 0)
+        close(probe);
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0 || setNonBlocking(fd) != 0) {
+        perror(path);
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static size_t pendingOutput(const ServerClient *client) {
+    return client->output.length - client->sent;
+}
+
+// Answers every complete line in the input buffer, in order.
+static void answerRequests(ServerClient *client) {
+    char *start = client->input, *end = client->input + client->inputLength;
+    char *newline;
+    while ((newline = memchr(start, '\n', (size_t)(end - start))) != NULL) {
+        *newline = '\0';
+        if (newline > start && newline[-1] == '\r')
+            newline[-1] = '\0';
+        if (client->discarding) {
+            client->discarding = 0;
+        } else {
+            INSTR_TIMER_START(command);
+            executeCommand(start, ++client->lineNumber, &client->state, &client->output);
+            INSTR_COMMAND_STOP(command, start[strspn(start, " \t")]);
+        }
+        start = newline + 1;
+    }
+    client->inputLength = (size_t)(end - start);
+    memmove(client->input, start, client->inputLength);
+
+    if (client->inputLength == sizeof(client->input)) {
+        if (!client->discarding)
+            outputPrintf(&client->output, "E %d line too long\n", ++client->lineNumber);
+        client->inputLength = 0;
+        client->discarding = 1;
+    } else if (client->peerClosed && client->inputLength > 0 && !client->discarding) {
+        // A last request without a newline still gets its reply.
+        client->input[client->inputLength] = '\0';
+        executeCommand(client->input, ++client->lineNumber, &client->state, &client->output);
+        client->inputLength = 0;
+    }
+}
+
+// Reads what the client has sent. Returns -1 if the connection failed.
+static int readRequests(ServerClient *client) {
+    // answerRequests never leaves the buffer full, so there is always room.
+    ssize_t received = read(client->fd, client->input + client->inputLength,
+                            sizeof(client->input) - client->inputLength);
+    if (received < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+    if (received == 0)
+        client->peerClosed = 1;
+    client->inputLength += (size_t)received;
+    answerRequests(client);
+    return 0;
+}
+
+// Writes as much of the pending output as the socket takes.
+// Returns -1 if the connection failed.
+static int writeReplies(ServerClient *client) {
+    while (pendingOutput(client) > 0) {
+        ssize_t written = send(client->fd, client->output.data + client->sent, pendingOutput(client),
+                               MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        client->sent += (size_t)written;
+    }
+    client->output.length = client->sent = 0;
+    return 0;
+}
+
+static ServerClient *acceptClient(int listener, const Planet *origin, double startTime) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0)
+        return NULL;
+    ServerClient *client = malloc(sizeof(ServerClient));
+    if (client == NULL || setNonBlocking(fd) != 0) {
+        free(client);
+        close(fd);
+        return NULL;
+    }
+    memset(client, 0, sizeof(*client));
+    client->fd = fd;
+    outputInit(&client->output, REPLY_BUFFER_SIZE, NULL);
+    initShipState(&client->state, origin, startTime);
+    return client;
+}
+
+static void closeClient(ServerClient *client) {
+    close(client->fd);
+    outputFree(&client->output);
+    free(client);
+}
+
+int runServer(const char *socketPath, const Planet *origin, double startTime) {
+    int listener = openListener(socketPath);
+    if (listener < 0)
+        return -1;
+    CommandLimits limits = { SERVER_MAX_STOPS, SERVER_MAX_GRID_CELLS, SERVER_MAX_STEPS,
+                             SERVER_MAX_APPROACH_BODY_DAYS };
+    setCommandLimits(&limits);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;  // no SA_RESTART, so poll returns
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    ServerClient **clients = NULL;
+    struct pollfd *fds = NULL;
+    int count = 0, capacity = 0, acceptPaused = 0, status = 0;
+    while (!stopRequested) {
+        INSTR_POLL();
+        if (count + 1 > capacity) {
+            int grown = capacity ? 2 * capacity : 64;
+            ServerClient **moreClients = realloc(clients, sizeof(ServerClient *) * grown);
+            if (moreClients != NULL)
+                clients = moreClients;
+            struct pollfd *moreFds = realloc(fds, sizeof(struct pollfd) * (grown + 1));
+            if (moreFds != NULL)
+                fds = moreFds;
+            if (moreClients == NULL || moreFds == NULL) {
+                status = -1;
+                break;
+            }
+            capacity = grown;
+        }
+
+        // Slot 0 is the listener; clients with a backlog of replies are not read.
+        fds[0].fd = acceptPaused ? -1 : listener;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < count; i++) {
+            ServerClient *client = clients[i];
+            fds[i + 1].fd = client->fd;
+            fds[i + 1].events = 0;
+            if (!client->peerClosed && pendingOutput(client) < SERVER_MAX_PENDING_OUTPUT)
+                fds[i + 1].events |= POLLIN;
+            if (pendingOutput(client) > 0)
+                fds[i + 1].events |= POLLOUT;
+        }
+        if (poll(fds, (nfds_t)count + 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            status = -1;
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            ServerClient *client = clients[i];
+            short events = fds[i + 1].revents;
+            int failed = 0;
+            if (events & (POLLIN | POLLHUP | POLLERR))
+                failed = readRequests(client) != 0;
+            // Replies go out right away rather than on the next wakeup.
+            if (!failed && pendingOutput(client) > 0)
+                failed = writeReplies(client) != 0;
+            if (failed || (client->peerClosed && pendingOutput(client) == 0)) {
+                closeClient(client);
+                clients[i] = NULL;
+                acceptPaused = 0;
+            }
+        }
+        int kept = 0;
+        for (int i = 0; i < count; i++) {
+            if (clients[i] != NULL)
+                clients[kept++] = clients[i];
+        }
+        count = kept;
+
+        if (fds[0].revents & POLLIN) {
+            while (count < capacity) {
+                ServerClient *client = acceptClient(listener, origin, startTime);
+                if (client == NULL) {
+                    // Out of descriptors: stop accepting until a client leaves.
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOMEM)
+                        acceptPaused = count > 0;
+                    break;
+                }
+                clients[count++] = client;
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+        closeClient(clients[i]);
+    free(clients);
+    free(fds);
+    close(listener);
+    unlink(socketPath);
+    setCommandLimits(NULL);
+    return status;
+}
@@ -0,0 +1,31 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "planet.h"
+
+// Largest request line the daemon accepts; longer lines get an error.
+#define SERVER_MAX_LINE 4096
+
+// Per-request caps (see setCommandLimits). Requests are answered one at a
+// time on a single thread, so a slow one holds up every client until it is
+// done; these keep the slowest commands to about a tenth of a second.
+#define SERVER_MAX_STOPS 16                 // R: solved exactly, by the fast path
+#define SERVER_MAX_GRID_CELLS 20000000L     // W
+#define SERVER_MAX_STEPS 100000L            // G
+#define SERVER_MAX_APPROACH_BODY_DAYS 5e8   // C: e.g. 10^5 days over 5000 bodies
+
+// A client's unsent replies may grow to this before the daemon stops reading
+// its requests until it catches up.
+#define SERVER_MAX_PENDING_OUTPUT (1 << 20)
+
+// Serves the batch command language (see executeCommand) on a Unix domain
+// socket until SIGINT or SIGTERM. Each connection has its own ship, starting
+// at origin at startTime; the catalog, arrival index and caches stay warm
+// across requests. Commands over the SERVER_MAX_* caps get an error line
+// instead of holding up the others. Requests are newline-terminated and may
+// be pipelined: every complete line read is answered in order, and the
+// replies to one read go out together. Returns 0 on a clean shutdown, -1 if
+// the socket cannot be set up.
+int runServer(const char *socketPath, const Planet *origin, double startTime);
+
+#endif
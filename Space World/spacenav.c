@@ -0,0 +1,128 @@
+#include "spacenav.h"
+#include <math.h>
+#include <string.h>
+
+#define PI 3.141592653589793
+#define NEAREST_BLOCK 256  // bodies evaluated per batch, on the stack
+
+void navContextInit(NavContext *context, const Planet *planets, BodySet bodies) {
+    context->planets = planets;
+    context->bodies = bodies;
+    context->cache = NULL;
+    context->grid = NULL;
+    context->arrivalThreshold = ARRIVAL_THRESHOLD;
+}
+
+// Computes Hohmann transfer time (in days) between two orbits.
+// Returns 0 if radii are nearly identical.
+double computeHohmannTransferTime(double r1, double r2) {
+    if (fabs(r1 - r2) < 1e-6)
+        return 0.0;
+    double a_transfer = (r1 + r2) / 2.0;
+    double period_transfer = 365.25 * pow(a_transfer, 1.5);
+    return period_transfer / 2.0;
+}
+
+// Computes phasing time for same-orbit transfers based on angular difference.
+double computePhasingTime(Vector3D current, Vector3D target, double orbitalPeriod) {
+    double angleCurrent = atan2(current.y, current.x);
+    double angleTarget  = atan2(target.y, target.x);
+    double dtheta = fabs(angleTarget - angleCurrent);
+    if (dtheta > PI)
+        dtheta = 2 * PI - dtheta;
+    return (dtheta / (2 * PI)) * orbitalPeriod;
+}
+
+static int cacheCovers(const NavContext *context, double time) {
+    const EphemerisCache *cache = context->cache;
+    return cache != NULL && cache->bodyCount == context->bodies.count &&
+           time >= cache->startTime && time <= cache->endTime;
+}
+
+Vector3D navBodyPosition(const NavContext *context, int body, double time) {
+    if (cacheCovers(context, time))
+        return ephemerisCachePosition(context->cache, body, time, NULL);
+    return computeBodyPosition(context->bodies, body, time, NULL);
+}
+
+int navNearestDestination(const NavContext *context, Vector3D position, double time, Vector3D *bodyPosition) {
+    double x[NEAREST_BLOCK], y[NEAREST_BLOCK], z[NEAREST_BLOCK];
+    double threshold = context->arrivalThreshold;
+    const SpatialGrid *grid = context->grid;
+    if (grid != NULL && grid->time == time && grid->count == context->bodies.count) {
+        int nearest = spatialGridNearest(grid, position, threshold, NULL);
+        if (nearest >= 0 && bodyPosition != NULL) {
+            bodyPosition->x = grid->x[nearest];
+            bodyPosition->y = grid->y[nearest];
+            bodyPosition->z = grid->z[nearest];
+        }
+        return nearest;
+    }
+    double bestDistance2 = threshold * threshold;
+    int best = -1, cached = cacheCovers(context, time);
+    for (int first = 0; first < context->bodies.count; first += NEAREST_BLOCK) {
+        int count = context->bodies.count - first < NEAREST_BLOCK ? context->bodies.count - first : NEAREST_BLOCK;
+        if (cached) {
+            for (int i = 0; i < count; i++) {
+                Vector3D p = ephemerisCachePosition(context->cache, first + i, time, NULL);
+                x[i] = p.x;
+                y[i] = p.y;
+                z[i] = p.z;
+            }
+        } else {
+            computePositionsBatch(bodySetSlice(context->bodies, first, count), &time, 1, x, y, z);
+        }
+        for (int i = 0; i < count; i++) {
+            double dx = x[i] - position.x, dy = y[i] - position.y, dz = z[i] - position.z;
+            double distance2 = dx * dx + dy * dy + dz * dz;
+            if (distance2 < bestDistance2) {
+                bestDistance2 = distance2;
+                best = first + i;
+                if (bodyPosition != NULL) {
+                    bodyPosition->x = x[i];
+                    bodyPosition->y = y[i];
+                    bodyPosition->z = z[i];
+                }
+            }
+        }
+    }
+    return best;
+}
+
+const char *navDescribe(const char *name) {
+    if (name == NULL)
+        return "You have arrived at an unknown celestial destination.";
+    if (strcmp(name, "Earth") == 0)
+        return "Earth: our vibrant blue home planet.";
+    if (strcmp(name, "Mars") == 0)
+        return "Mars: the Red Planet, a potential destination for exploration.";
+    if (strcmp(name, "Saturn") == 0)
+        return "Saturn: adorned with magnificent rings.";
+    return "A known celestial destination.";
+}
+
+void navSetDestination(const NavContext *context, ShipState *ship, int body, Vector3D position, double time) {
+    ship->currentDestination.index = body;
+    ship->currentDestination.name = body >= 0 ? context->planets[body].name : "Unknown";
+    ship->currentDestination.description = navDescribe(body >= 0 ? context->planets[body].name : NULL);
+    ship->currentDestination.position = position;
+    ship->currentDestination.arrivalTime = time;
+}
+
+void navDetermineDestination(const NavContext *context, ShipState *ship, Vector3D position, double time) {
+    Vector3D bodyPosition;
+    int body = navNearestDestination(context, position, time, &bodyPosition);
+    navSetDestination(context, ship, body, body >= 0 ? bodyPosition : position, time);
+}
+
+void navInitShip(const NavContext *context, ShipState *ship, int origin, double time) {
+    ship->currentTime = time;
+    ship->shipPosition = navBodyPosition(context, origin, time);
+    navDetermineDestination(context, ship, ship->shipPosition, time);
+}
+
+void navTravel(const NavContext *context, ShipState *ship, Vector3D position, double duration) {
+    ship->shipPosition = position;
+    ship->currentTime += duration;
+    navDetermineDestination(context, ship, position, ship->currentTime);
+}
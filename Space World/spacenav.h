@@ -0,0 +1,79 @@
+#ifndef SPACENAV_H
+#define SPACENAV_H
+
+#include "planet.h"
+#include "ephemeris.h"
+#include "chebyshev.h"
+#include "spatial.h"
+
+// libspacenav: the navigation core without the console. Nothing here does
+// I/O or keeps state between calls; every input is an argument. The queries
+// below allocate nothing. The structures they read (Kepler orbit sets,
+// Chebyshev caches, spatial grids) are built and freed by the caller with
+// the allocating functions of kepler.h, chebyshev.h and spatial.h.
+// A NavContext and the storage it points to may be shared by any number of
+// threads while no one modifies them, and each thread works on its own
+// ShipState.
+
+// Distance (AU) within which the ship counts as arrived at a destination.
+#define ARRIVAL_THRESHOLD 0.1
+
+// The ship's state.
+typedef struct {
+    double currentTime;
+    Vector3D shipPosition;
+    struct {
+        int index;                // into the context's catalog, -1 if none
+        const char *name;         // the catalog's name or "Unknown"; valid while the catalog is
+        const char *description;  // static text
+        Vector3D position;
+        double arrivalTime;
+    } currentDestination;
+} ShipState;
+
+// A read-only destination catalog and how to evaluate it.
+typedef struct {
+    const Planet *planets;          // names, indexed like bodies
+    BodySet bodies;                 // orbits
+    const EphemerisCache *cache;    // serves positions within its span if not NULL
+    const SpatialGrid *grid;        // answers arrival queries at its time if not NULL;
+                                    // its cell size should be at least the threshold
+    double arrivalThreshold;        // AU
+} NavContext;
+
+// A context over planets and bodies with no cache or grid and ARRIVAL_THRESHOLD.
+void navContextInit(NavContext *context, const Planet *planets, BodySet bodies);
+
+// Hohmann transfer time (days) between circular orbits; 0 if the radii are nearly identical.
+double computeHohmannTransferTime(double r1, double r2);
+
+// Time (days) to cover the angle between current and target on an orbit of orbitalPeriod.
+double computePhasingTime(Vector3D current, Vector3D target, double orbitalPeriod);
+
+// Position of catalog body at time, from the cache when it covers the time.
+Vector3D navBodyPosition(const NavContext *context, int body, double time);
+
+// Nearest catalog body within the arrival threshold of position at time,
+// from the context's grid if it indexes the catalog at that time, otherwise
+// scanning in blocks on the stack. Stores its position if bodyPosition is
+// not NULL. Returns its index, or -1 if there is none.
+int navNearestDestination(const NavContext *context, Vector3D position, double time, Vector3D *bodyPosition);
+
+// Description of a destination by name (static text).
+const char *navDescribe(const char *name);
+
+// Records the ship's destination as catalog body, or no known destination if
+// body is -1, reached at position and time.
+void navSetDestination(const NavContext *context, ShipState *ship, int body, Vector3D position, double time);
+
+// Sets the ship's destination to the body within the arrival threshold of
+// position at time, or to no known destination.
+void navDetermineDestination(const NavContext *context, ShipState *ship, Vector3D position, double time);
+
+// Places the ship at catalog body origin at time, arrived there.
+void navInitShip(const NavContext *context, ShipState *ship, int origin, double time);
+
+// Moves the ship to position after duration days and detects the arrival.
+void navTravel(const NavContext *context, ShipState *ship, Vector3D position, double duration);
+
+#endif
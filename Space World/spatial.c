@@ -0,0 +1,140 @@
+#include "spatial.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+void spatialGridInit(SpatialGrid *grid, double cellSize) {
+    memset(grid, 0, sizeof(*grid));
+    grid->cellSize = cellSize;
+    grid->time = NAN;
+}
+
+void spatialGridFree(SpatialGrid *grid) {
+    free(grid->cellStart);
+    free(grid->order);
+    free(grid->cellOf);
+    free(grid->x);
+    free(grid->y);
+    free(grid->z);
+    spatialGridInit(grid, grid->cellSize);
+}
+
+// Hashes integer cell coordinates into a bucket.
+static unsigned hashCell(long ix, long iy, long iz, unsigned mask) {
+    unsigned long h = (unsigned long)ix * 73856093u ^ (unsigned long)iy * 19349663u
+                    ^ (unsigned long)iz * 83492791u;
+    return (unsigned)(h ^ (h >> 29)) & mask;
+}
+
+static long cellCoord(double v, double cellSize) {
+    return (long)floor(v / cellSize);
+}
+
+int spatialGridReserve(SpatialGrid *grid, int count) {
+    if (grid->cellStart == NULL) {
+        // Even an empty grid has its (empty) buckets, so refits and queries work.
+        grid->cellStart = calloc(16 + 1, sizeof(int));
+        if (grid->cellStart == NULL)
+            return -1;
+        grid->cellMask = 15;
+    }
+    if (count > grid->capacity) {
+        // Blocks that did grow are only larger than needed, so on failure the
+        // grid keeps its old capacity and stays usable.
+        double **columns[] = { &grid->x, &grid->y, &grid->z };
+        for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++) {
+            double *grown = realloc(*columns[c], sizeof(double) * count);
+            if (grown == NULL)
+                return -1;
+            *columns[c] = grown;
+        }
+        int *order = realloc(grid->order, sizeof(int) * count);
+        if (order == NULL)
+            return -1;
+        grid->order = order;
+        unsigned *cellOf = realloc(grid->cellOf, sizeof(unsigned) * count);
+        if (cellOf == NULL)
+            return -1;
+        grid->cellOf = cellOf;
+
+        // About one bucket per body keeps buckets short without wasting memory.
+        unsigned buckets = 16;
+        while (buckets < (unsigned)count)
+            buckets *= 2;
+        int *cellStart = realloc(grid->cellStart, sizeof(int) * (buckets + 1));
+        if (cellStart == NULL)
+            return -1;
+        grid->cellStart = cellStart;
+        grid->cellMask = buckets - 1;
+        grid->capacity = count;
+    }
+    grid->count = count;
+    return 0;
+}
+
+void spatialGridRefit(SpatialGrid *grid, double time) {
+    unsigned buckets = grid->cellMask + 1;
+    grid->time = time;
+
+    // Counting sort of the bodies by bucket.
+    memset(grid->cellStart, 0, sizeof(int) * (buckets + 1));
+    for (int i = 0; i < grid->count; i++) {
+        unsigned c = hashCell(cellCoord(grid->x[i], grid->cellSize),
+                              cellCoord(grid->y[i], grid->cellSize),
+                              cellCoord(grid->z[i], grid->cellSize), grid->cellMask);
+        grid->cellOf[i] = c;
+        grid->cellStart[c + 1]++;
+    }
+    for (unsigned c = 0; c < buckets; c++)
+        grid->cellStart[c + 1] += grid->cellStart[c];
+    // Scatter in reverse so each bucket ends up in ascending body order.
+    for (int i = grid->count - 1; i >= 0; i--) {
+        unsigned c = grid->cellOf[i];
+        grid->order[grid->cellStart[c + 1] - 1] = i;
+        grid->cellStart[c + 1]--;
+    }
+    // cellStart[c + 1] now holds the start of bucket c; shift back by one.
+    memmove(grid->cellStart, grid->cellStart + 1, sizeof(int) * buckets);
+    grid->cellStart[buckets] = grid->count;
+}
+
+int spatialGridBuild(SpatialGrid *grid, BodySet bodies, double time) {
+    if (spatialGridReserve(grid, bodies.count) != 0)
+        return -1;
+    computePositionsBatch(bodies, &time, 1, grid->x, grid->y, grid->z);
+    spatialGridRefit(grid, time);
+    return 0;
+}
+
+int spatialGridNearest(const SpatialGrid *grid, Vector3D pos, double radius, double *distance) {
+    int best = -1;
+    if (grid->count == 0)
+        return -1;
+    double bestDist2 = radius * radius;
+    long x0 = cellCoord(pos.x - radius, grid->cellSize), x1 = cellCoord(pos.x + radius, grid->cellSize);
+    long y0 = cellCoord(pos.y - radius, grid->cellSize), y1 = cellCoord(pos.y + radius, grid->cellSize);
+    long z0 = cellCoord(pos.z - radius, grid->cellSize), z1 = cellCoord(pos.z + radius, grid->cellSize);
+
+    for (long ix = x0; ix <= x1; ix++) {
+        for (long iy = y0; iy <= y1; iy++) {
+            for (long iz = z0; iz <= z1; iz++) {
+                unsigned c = hashCell(ix, iy, iz, grid->cellMask);
+                for (int k = grid->cellStart[c]; k < grid->cellStart[c + 1]; k++) {
+                    int i = grid->order[k];
+                    double dx = grid->x[i] - pos.x;
+                    double dy = grid->y[i] - pos.y;
+                    double dz = grid->z[i] - pos.z;
+                    double d2 = dx * dx + dy * dy + dz * dz;
+                    // Strictly inside the radius; ties go to the lower index.
+                    if (d2 < bestDist2 || (d2 == bestDist2 && best >= 0 && i < best)) {
+                        bestDist2 = d2;
+                        best = i;
+                    }
+                }
+            }
+        }
+    }
+    if (best >= 0 && distance != NULL)
+        *distance = sqrt(bestDist2);
+    return best;
+}
@@ -0,0 +1,39 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "planet.h"
+#include "ephemeris.h"
+
+// Uniform hashed grid over body positions at one epoch.
+// Bodies are bucketed by cell so radius queries only touch nearby cells.
+typedef struct {
+    double cellSize;   // in AU; queries are cheapest when radius <= cellSize
+    double time;       // epoch the positions were computed for
+    int count;         // number of indexed bodies
+    int capacity;      // allocated body slots
+    unsigned cellMask; // cell table size - 1 (size is a power of two)
+    int *cellStart;    // bodies in bucket c are order[cellStart[c] .. cellStart[c + 1])
+    int *order;        // body indices sorted by bucket
+    unsigned *cellOf;  // bucket of each body
+    double *x, *y, *z; // body positions, by body index
+} SpatialGrid;
+
+void spatialGridInit(SpatialGrid *grid, double cellSize);
+void spatialGridFree(SpatialGrid *grid);
+
+// Computes every body's position at time and rebuilds the index.
+// Returns 0, or -1 on allocation failure (the grid keeps its old contents).
+int spatialGridBuild(SpatialGrid *grid, BodySet bodies, double time);
+
+// Rebuilds the index from positions already stored in grid->x/y/z
+// (sized with spatialGridReserve), e.g. by another ephemeris source.
+// spatialGridReserve returns 0, or -1 on allocation failure, in which case
+// the grid keeps its old capacity and contents.
+int spatialGridReserve(SpatialGrid *grid, int count);
+void spatialGridRefit(SpatialGrid *grid, double time);
+
+// Returns the index of the body nearest to pos within radius, or -1.
+// If distance is not NULL it receives the distance to that body.
+int spatialGridNearest(const SpatialGrid *grid, Vector3D pos, double radius, double *distance);
+
+#endif
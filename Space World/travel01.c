@@ -1,7 +1,6 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
-#include <string.h>
 
 #define PI 3.141592653589793
 #define THRESHOLD 0.1  // distance tolerance (in AU) to consider as "arrived"
@@ -22,12 +21,19 @@ typedef struct {
 
 // Structure to store a location.
 typedef struct {
-    char name[64];
-    char description[256];
+    const char *name;         // static text
+    const char *description;
     Vector3D position;
     double arrivalTime;
 } Location;
 
+// Structure to store the ship's state.
+typedef struct {
+    double currentTime;
+    Vector3D shipPosition;
+    Location currentLocation;
+} Ship;
+
 // Prints current ship status info.
 void printInfo(double departureTime, Vector3D shipPosition, const char *locName, const char *locDescription) {
   double distanceFromSun = sqrt(shipPosition.x * shipPosition.x + shipPosition.y * shipPosition.y);
@@ -94,22 +100,21 @@ int checkNavigation(Vector3D playerInput, Vector3D targetPosition) {
 }
 
 // (Optional) Prints an ephemeris table for a planet over a given time range.
+// space_export (export.c) writes large multi-body tables.
 void printEphemeris(Planet planet, double startTime, double endTime, double interval) {
     printf("\nEphemeris for %s:\n", planet.name);
     printf("Time (days)    x (AU)      y (AU)\n");
-    for (double t = startTime; t <= endTime; t += interval) {
+    // Times come from the row index; adding interval each step drifts.
+    long rows = (long)floor((endTime - startTime) / interval * (1.0 + 1e-12)) + 1;
+    for (long k = 0; k < rows; k++) {
+        double t = startTime + (double)k * interval;
         Vector3D pos = getPlanetPosition(planet, t);
         printf("%8.2f    %8.4f    %8.4f\n", t, pos.x, pos.y);
     }
     printf("\n");
 }
 
-// Global variables for the ship's state.
-double currentTime = 100.0; // initial departure time (in days)
-Vector3D shipPosition;      // current ship position
-Location currentLocation;   // current location info
-
-// Determines the current location based on shipPosition and currentTime.
+// Determines the location at pos and time.
 // If the ship is close to Earth or Mars (within THRESHOLD), update accordingly; otherwise, mark as "Unknown."
 void determineLocation(Vector3D pos, double time, Location *loc) {
     Planet earth = { "Earth", 1.0, 365.25 };
@@ -121,28 +126,28 @@ void determineLocation(Vector3D pos, double time, Location *loc) {
     double dMars  = calculateDistance(pos, marsPos);
     
     if (dEarth < THRESHOLD) {
-         strcpy(loc->name, "Earth");
-         strcpy(loc->description, "Earth: our vibrant blue home planet.");
+         loc->name = "Earth";
+         loc->description = "Earth: our vibrant blue home planet.";
          loc->position = earthPos;
          loc->arrivalTime = time;
     } else if (dMars < THRESHOLD) {
-         strcpy(loc->name, "Mars");
-         strcpy(loc->description, "Mars: the Red Planet, a potential destination for exploration.");
+         loc->name = "Mars";
+         loc->description = "Mars: the Red Planet, a potential destination for exploration.";
          loc->position = marsPos;
          loc->arrivalTime = time;
     } else {
-         strcpy(loc->name, "Unknown");
-         strcpy(loc->description, "You have arrived at an unknown celestial location.");
+         loc->name = "Unknown";
+         loc->description = "You have arrived at an unknown celestial location.";
          loc->position = pos;
          loc->arrivalTime = time;
     }
 }
 
-// Updates the current location based on the new shipPosition and arrival time.
-void updateCurrentLocation(double arrivalTime) {
-    currentTime = arrivalTime;
-    determineLocation(shipPosition, currentTime, &currentLocation);
-    printf("You have arrived at %s.\n", currentLocation.name);
+// Updates the ship's location based on its new position and arrival time.
+void updateCurrentLocation(Ship *ship, double arrivalTime) {
+    ship->currentTime = arrivalTime;
+    determineLocation(ship->shipPosition, ship->currentTime, &ship->currentLocation);
+    printf("You have arrived at %s.\n", ship->currentLocation.name);
 }
 
 void printMenu() {
@@ -165,7 +170,7 @@ void printFormulae() {
 }
 
 // TRAVEL SYSTEM: Let the player input their calculated trajectory.
-void travelSystemExecute() {
+void travelSystemExecute(Ship *ship) {
   Vector3D playerCalculated;
   printf("\nEnter your calculated X coordinate: ");
   scanf("%lf", &playerCalculated.x);
@@ -178,10 +183,10 @@ void travelSystemExecute() {
   scanf("%lf", &arrivalTime);
   
   // Update ship state from player's input.
-  shipPosition = playerCalculated;
-  currentTime = arrivalTime;
+  ship->shipPosition = playerCalculated;
+  ship->currentTime = arrivalTime;
   // Determine the new location.
-  updateCurrentLocation(arrivalTime);
+  updateCurrentLocation(ship, arrivalTime);
 }
 
 int main(void) {
@@ -190,15 +195,17 @@ int main(void) {
     Planet mars  = { "Mars", 1.523, 687.0 };
     
     // Initialize ship's starting position at Earth.
-    shipPosition = getPlanetPosition(earth, currentTime);
-    strcpy(currentLocation.name, "Earth");
-    strcpy(currentLocation.description, "Earth: our vibrant blue home planet.");
-    currentLocation.position = shipPosition;
-    currentLocation.arrivalTime = currentTime;
+    Ship ship;
+    ship.currentTime = 100.0; // initial departure time (in days)
+    ship.shipPosition = getPlanetPosition(earth, ship.currentTime);
+    ship.currentLocation.name = "Earth";
+    ship.currentLocation.description = "Earth: our vibrant blue home planet.";
+    ship.currentLocation.position = ship.shipPosition;
+    ship.currentLocation.arrivalTime = ship.currentTime;
     
     // Initial mission briefing.
     printf("You are on << Mineral-Raider-1 >>\n\n");
-    printInfo(currentTime, shipPosition, currentLocation.name, currentLocation.description);
+    printInfo(ship.currentTime, ship.shipPosition, ship.currentLocation.name, ship.currentLocation.description);
     
     // Interactive Menu Loop.
     char choice;
@@ -215,9 +222,9 @@ int main(void) {
         } else if (choice == 'H' || choice == 'h') {
             hohmannTransferTime();
         } else if (choice == 'T' || choice == 't') {
-            travelSystemExecute();
+            travelSystemExecute(&ship);
         } else if (choice == 'I' || choice == 'i') {
-            printInfo(currentTime, shipPosition, currentLocation.name, currentLocation.description);
+            printInfo(ship.currentTime, ship.shipPosition, ship.currentLocation.name, ship.currentLocation.description);
         } else if (choice == 'M' || choice == 'm') {
           printMenu();
         } else if (choice == '0') {